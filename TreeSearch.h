@@ -4,55 +4,223 @@
 #ifndef TREESEARCH_H
 #define TREESEARCH_H
 
-#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "movelist.h"
+#include "searchstats.h"
+#include "transposition.h"
 
+#define MAX_PLY 81
+#define DEADLINE_CHECK_NODES 1024    // Power of two
+
+// Move ordering knowledge gathered during a search: killer moves (the last two moves that caused a
+// cutoff at each ply) and a history score per move and side. Each search thread keeps its own.
+template <class M>
+struct MoveOrdering {
+    M killers[MAX_PLY][2];
+    int history[2][256];
+
+    MoveOrdering() { Clear(); }
+
+    void Clear()
+    {
+        for (auto &killer : killers) killer[0] = killer[1] = M(TT_NO_MOVE);
+        for (auto &side : history) for (int &score : side) score = 0;
+    }
+
+    // Between turns the killers are meaningless, but history still says something
+    void Age()
+    {
+        for (auto &killer : killers) killer[0] = killer[1] = M(TT_NO_MOVE);
+        for (auto &side : history) for (int &score : side) score /= 8;
+    }
+};
+
+// Alpha-beta search over a game described by a policy type with these static members:
+//
+//   Position, Move, Undo                       Moves must fit in a byte so they can be stored in the transposition table
+//   GenerateMoves(const Position &, MoveList<Move> &)
+//   MakeMove(Position &, Move, Undo &), UnmakeMove(Position &, Move, const Undo &)
+//   Evaluate(const Position &)                 Rating for the side to move, the opponent's rating is its negation
+//   Hash(const Position &)
+//   Probe(const Position &, int &value)        Exact rating for the side to move from outside the search, if known
+//
+// Every call is resolved at compile time, so the policy can be inlined into the recursion. Without Pruning there
+// are no alpha-beta or transposition table cutoffs, which makes it a plain minimax to check the real thing against.
+// Without CollectStats only the node count, which the limits need, is kept.
+template <class Policy, bool Pruning = true, bool CollectStats = true>
 class TreeSearch {
+    using Position = typename Policy::Position;
+    using Move = typename Policy::Move;
+    using Undo = typename Policy::Undo;
+
+    TranspositionTable *table;
+    MoveOrdering<Move> *ordering;
+    std::atomic<bool> stopped{false};
+    std::atomic<bool> *stop;           // Shared by all threads working on the same search
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    long nodeLimit = 0;
+    SearchCounters counters;
+    int ply = 0;
+
+    void OrderMoves(MoveList<Move> &moves, int hashMove) const;
+    void RecordCutoff(Move move, int index, int depth);
+
 public:
-    template <class O>
-    static int MiniMaxAB(O branch, int (*evaluate)(const O &, const Player &), std::vector<O> (*findChildNodes)(const O &), int depth, bool maximize, Player p, int worstVal, int bestVal, bool *isFullTreeEvaluated);
+    TreeSearch(TranspositionTable *table, MoveOrdering<Move> *ordering, std::atomic<bool> *stop = nullptr)
+            : table(table), ordering(ordering), stop(stop ? stop : &stopped) {}
 
+    // The search stops itself once the deadline has passed, the clock is read every DEADLINE_CHECK_NODES nodes
+    void SetDeadline(std::chrono::steady_clock::time_point time) { deadline = time; }
+    // Stops the search after about this many nodes (0 = no limit), checked together with the deadline
+    void SetNodeLimit(long limit) { nodeLimit = limit; }
+    bool Stopped() const { return stop->load(std::memory_order_relaxed); }
+    long Nodes() const { return counters.nodes; }
+    const SearchCounters &Counters() const { return counters; }
+
+    // Rating of the position for the side to move, within the window alpha..beta
+    int NegaMax(Position &node, int depth, int alpha, int beta, bool *isFullTreeEvaluated);
 };
 
-#endif //TREESEARCH_H
+// treesearch.cpp
+// Sorts the moves so the likeliest cutoffs come first: the best move stored in the transposition table,
+// then this ply's killer moves, then everything else by history score. Plies of the same parity belong
+// to the same side, so that is what the history is kept by.
+template<class Policy, bool Pruning, bool CollectStats>
+void TreeSearch<Policy, Pruning, CollectStats>::OrderMoves(MoveList<Move> &moves, int hashMove) const
+{
+    const Move *killers = ordering->killers[ply];
+    const int *history = ordering->history[ply & 1];
+    int scores[MAX_MOVES];
+
+    for(int i = 0; i < moves.size(); i++) {
+        Move move = moves[i];
+        if(move == hashMove) scores[i] = 1 << 30;
+        else if(move == killers[0]) scores[i] = 1 << 29;
+        else if(move == killers[1]) scores[i] = 1 << 28;
+        else scores[i] = history[move];
+    }
 
+    // Insertion sort, move lists are short and usually close to sorted already
+    for(int i = 1; i < moves.size(); i++) {
+        Move move = moves[i];
+        int score = scores[i];
+        int j = i;
+        for(; j > 0 && scores[j-1] < score; j--) {
+            moves[j] = moves[j-1];
+            scores[j] = scores[j-1];
+        }
+        moves[j] = move;
+        scores[j] = score;
+    }
+}
 
-// treesearch.cpp
-template<class O>
-int TreeSearch::MiniMaxAB(O branch, int (*evaluate)(const O &, const Player &), std::vector<O> (*findChildNodes)(const O &), int depth, bool maximize, Player p, int worstVal, int bestVal, bool *isFullTreeEvaluated)
+template<class Policy, bool Pruning, bool CollectStats>
+void TreeSearch<Policy, Pruning, CollectStats>::RecordCutoff(Move move, int index, int depth)
 {
-    // Get all child nodes with function passed as argument
-    auto children = findChildNodes(branch);
+    if constexpr (CollectStats) {
+        counters.cutoffs++;
+        counters.cutoffsAt[std::min(index, CUTOFF_SLOTS - 1)]++;
+    }
+
+    Move *killers = ordering->killers[ply];
+    if(killers[0] != move) {
+        killers[1] = killers[0];
+        killers[0] = move;
+    }
+    ordering->history[ply & 1][move] += depth * depth;
+}
+
+// Children are visited by playing each move on the node itself and taking it back afterwards,
+// so no child nodes are ever copied. Moves are kept in a MoveList on the stack: no heap allocations per node.
+// Every rating is from the point of view of the side to move, a child's rating is negated on the way up, and
+// that is also how results are cached in the transposition table.
+// Once the search is stopped every node returns straight away; the values it returns are meaningless
+// and are not stored.
+template<class Policy, bool Pruning, bool CollectStats>
+int TreeSearch<Policy, Pruning, CollectStats>::NegaMax(Position &node, int depth, int alpha, int beta, bool *isFullTreeEvaluated)
+{
+    long nodes = ++counters.nodes;
+    if((nodes & (DEADLINE_CHECK_NODES - 1)) == 0 && ((nodeLimit && nodes >= nodeLimit) || std::chrono::steady_clock::now() >= deadline))
+        stop->store(true, std::memory_order_relaxed);
+    if(Stopped()) return 0;
+    if constexpr (CollectStats) {
+        if(ply > counters.maxPly) counters.maxPly = ply;
+    }
+
+    const int originalAlpha = alpha;
+    const uint64_t key = Policy::Hash(node);
+    int hashMove = TT_NO_MOVE;
+
+    TTEntry entry;
+    if constexpr (CollectStats) {
+        if(depth > 0) counters.ttProbes++;
+    }
+    if(depth > 0 && table->Probe(key, entry)) {
+        if constexpr (CollectStats) counters.ttHits++;
+        hashMove = entry.move;
+        if(Pruning && entry.depth >= depth) {
+            int stored = entry.value;
+            if(entry.bound == Bound::Exact || (entry.bound == Bound::Lower && stored >= beta) || (entry.bound == Bound::Upper && stored <= alpha)) {
+                if(entry.depth != TT_DEPTH_SOLVED) *isFullTreeEvaluated = false;
+                if constexpr (CollectStats) counters.ttCutoffs++;
+                return stored;
+            }
+        }
+    }
+
+    // Outside knowledge costs more than a table lookup, so it is only asked once the table had no answer,
+    // and what it says is kept as solved so the next visit stops at the table
+    int known;
+    if(Policy::Probe(node, known)) {
+        if constexpr (CollectStats) counters.tbHits++;
+        if(depth > 0) table->Store(key, known, TT_DEPTH_SOLVED, Bound::Exact, TT_NO_MOVE);
+        return known;
+    }
+
+    MoveList<Move> moves;
+    Policy::GenerateMoves(node, moves);
 
-    // This branch has no children, all we can do is evaluate it now
-    if(children.empty()) {
-        return evaluate(branch, p);
+    // This node has no children, all we can do is evaluate it now
+    if(moves.empty()) {
+        if constexpr (CollectStats) counters.leaves++;
+        return Policy::Evaluate(node);
     }
 
     // Depth limit has been reached, return value of current node
     if(depth == 0) {
         *isFullTreeEvaluated = false;
-        return evaluate(branch, p);
+        if constexpr (CollectStats) counters.leaves++;
+        return Policy::Evaluate(node);
     }
 
-    int value;
-    if(maximize) {
-        value = worstVal;
-        for(O child:children) {
-            int childVal = MiniMaxAB(child, evaluate, findChildNodes, depth-1, false, p, worstVal, bestVal, isFullTreeEvaluated);
-            if(childVal > value) value = childVal;
-            if(value > worstVal) worstVal = value;
-            if(worstVal >= bestVal) break;
-        }
-    } else {
-        value = bestVal;
-        for(O child:children) {
-            int childVal = MiniMaxAB(child, evaluate, findChildNodes, depth-1, true, p, worstVal, bestVal, isFullTreeEvaluated);
-            if(childVal < value) value = childVal;
-            if(value < bestVal) bestVal = value;
-            if(worstVal >= bestVal) break;
-        }
+    OrderMoves(moves, hashMove);
+
+    bool fullTree = true;
+    int value = alpha;
+    Move bestMove = moves[0];
+    Undo undo;
+    int index = 0;      // Of the move being searched, for the cutoff statistics
+    for(Move move : moves) {
+        Policy::MakeMove(node, move, undo);
+        ply++;
+        int childVal = -NegaMax(node, depth-1, -beta, -alpha, &fullTree);
+        ply--;
+        Policy::UnmakeMove(node, move, undo);
+        if(childVal > value) { value = childVal; bestMove = move; }
+        if(value > alpha) alpha = value;
+        if(Pruning && alpha >= beta) { RecordCutoff(move, index, depth); break; }
+        index++;
     }
+    if(!fullTree) *isFullTreeEvaluated = false;
+    if(Stopped()) return 0;
+
+    Bound bound = value <= originalAlpha ? Bound::Upper : value >= beta ? Bound::Lower : Bound::Exact;
+    table->Store(key, value, fullTree ? TT_DEPTH_SOLVED : depth, bound, bestMove);
 
     return value;
 }
 
+#endif //TREESEARCH_H
@@ -0,0 +1,14 @@
+// alloccounter.h
+
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+// Counts heap allocations made by the whole process. Only active in builds configured with
+// UTTT_COUNT_ALLOCATIONS, which replace the global operator new; otherwise Count() stays 0.
+class AllocCounter {
+public:
+    static bool Enabled();
+    static long Count();
+};
+
+#endif //ALLOCCOUNTER_H
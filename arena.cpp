@@ -0,0 +1,263 @@
+// arena.cpp
+// Plays matches between two engine configurations, several games at a time, and reports which one is stronger.
+//
+// utttarena [-a spec] [-b spec] [--games N] [--concurrency N] [--tpm ms] [--timebank ms]
+//           [--opening-plies N] [--seed S] [--tablebase file] [--book file]
+//           [--verbose]
+//
+// An engine spec is a comma separated list of settings, for example engine=mcts,mcts-mb=32 or
+// engine=minimax,hash=16,threads=2,nodes=200000,proof=25. Games start from a few random moves; every opening is
+// played twice with the colours swapped. With the same seed and node budgets on single threaded engines
+// every game is reproducible.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bitboard.h"
+#include "book.h"
+#include "fastrandom.h"
+#include "log.h"
+#include "tablebase.h"
+#include "utttai.h"
+
+#define DEFAULT_ARENA_GAMES 100
+#define DEFAULT_ARENA_TIMEBANK 10000
+#define DEFAULT_ARENA_TIME_PER_MOVE 100
+#define DEFAULT_OPENING_PLIES 2
+
+struct ArenaOptions {
+    std::string specs[2] = {"engine=minimax", "engine=minimax"};
+    AIOptions engines[2];
+    int games = DEFAULT_ARENA_GAMES;
+    int concurrency = 0;
+    int timebank = DEFAULT_ARENA_TIMEBANK;
+    int timePerMove = DEFAULT_ARENA_TIME_PER_MOVE;
+    int openingPlies = DEFAULT_OPENING_PLIES;
+    uint64_t seed = 1;
+    bool verbose = false;
+};
+
+// Everything counted for one engine
+struct EngineTotals {
+    long moves = 0;
+    long depth = 0;
+    long nodes = 0;
+    long milliseconds = 0;
+    int timeouts = 0;
+    int illegalMoves = 0;
+
+    void Add(const EngineTotals &other)
+    {
+        moves += other.moves;
+        depth += other.depth;
+        nodes += other.nodes;
+        milliseconds += other.milliseconds;
+        timeouts += other.timeouts;
+        illegalMoves += other.illegalMoves;
+    }
+};
+
+// Results are from the point of view of engine A
+struct MatchTotals {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+    EngineTotals engines[2];
+};
+
+static bool ParseEngine(const std::string &spec, AIOptions &options)
+{
+    std::stringstream settings(spec);
+    std::string setting;
+    while (std::getline(settings, setting, ',')) {
+        size_t split = setting.find('=');
+        if (split == std::string::npos) {
+            std::cout << "Engine setting without a value: " << setting << std::endl;
+            return false;
+        }
+        std::string key = setting.substr(0, split);
+        std::string value = setting.substr(split + 1);
+        if (key == "engine" && value == "minimax") options.engine = Engine::Minimax;
+        else if (key == "engine" && value == "mcts") options.engine = Engine::MCTS;
+        else if (key == "hash") options.hashMegabytes = std::stoi(value);
+        else if (key == "threads") options.threads = std::max(1, std::stoi(value));
+        else if (key == "mcts-mb") options.mctsMegabytes = std::max(1, std::stoi(value));
+        else if (key == "nodes") options.nodesPerMove = std::stol(value);
+        else if (key == "proof") options.proofShare = std::max(0, std::min(100, std::stoi(value)));
+        else if (key == "proof-mb") options.proofMegabytes = std::max(1, std::stoi(value));
+        else {
+            std::cout << "Unknown engine setting: " << setting << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Plays one game and adds it to the totals. Engine A has X in even games and O in odd ones.
+static void PlayGame(const ArenaOptions &options, int game, MatchTotals &totals)
+{
+    FastRandom random(options.seed + game / 2);
+    BitState position;
+    MoveList<int> moves;
+    Undo undo;
+    for (int ply = 0; ply < options.openingPlies; ply++) {
+        getMoveIndices(position, moves);
+        if (moves.empty()) break;
+        makeMove(position, moves[random.Below(moves.size())], undo);
+    }
+
+    const int engineOfSide[2] = {game % 2, 1 - game % 2};
+    std::unique_ptr<UTTTAI> ai[2];
+    int timebank[2];
+    for (int e = 0; e < 2; e++) {
+        AIOptions engine = options.engines[e];
+        engine.seed = options.seed * 1000003 + game * 2 + e;
+        ai[e].reset(new UTTTAI(engine));
+        timebank[e] = options.timebank;
+    }
+
+    int loser = -1;     // Engine that lost on time or by an illegal move
+    for (getMoveIndices(position, moves); !moves.empty() && loser < 0; getMoveIndices(position, moves)) {
+        int e = engineOfSide[position.side];
+        EngineTotals &engine = totals.engines[e];
+
+        auto start = std::chrono::steady_clock::now();
+        SearchStats stats;
+        Move move = ai[e]->findBestMove(toState(position), timebank[e], options.timePerMove, &stats);
+        long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+        engine.moves++;
+        engine.depth += stats.depth;
+        engine.nodes += stats.nodes;
+        engine.milliseconds += elapsed;
+
+        timebank[e] -= elapsed;
+        if (timebank[e] < 0) {
+            engine.timeouts++;
+            loser = e;
+            break;
+        }
+        timebank[e] = std::min(options.timebank, timebank[e] + options.timePerMove);
+
+        int index = move.x >= 0 && move.x < 9 && move.y >= 0 && move.y < 9 ? toIndex(move) : -1;
+        if (std::find(moves.begin(), moves.end(), index) == moves.end()) {
+            engine.illegalMoves++;
+            loser = e;
+            break;
+        }
+        makeMove(position, index, undo);
+    }
+
+    int winner = loser >= 0 ? 1 - loser : getWinner(position) == Player::None ? -1 : engineOfSide[toSide(getWinner(position))];
+    if (winner == 0) totals.wins++;
+    else if (winner == 1) totals.losses++;
+    else totals.draws++;
+}
+
+// Elo difference belonging to a score between 0 and 1
+static double Elo(double score)
+{
+    return 400.0 * std::log10(score / (1.0 - score));
+}
+
+static void Report(const ArenaOptions &options, const MatchTotals &totals)
+{
+    int games = totals.wins + totals.draws + totals.losses;
+    double score = (totals.wins + 0.5 * totals.draws) / games;
+
+    // 95% confidence interval of the score, from the spread of the individual game results
+    double variance = (totals.wins * std::pow(1.0 - score, 2) + totals.draws * std::pow(0.5 - score, 2) + totals.losses * std::pow(score, 2)) / games;
+    double margin = 1.96 * std::sqrt(variance / games);
+
+    std::cout << std::endl << "A: " << options.specs[0] << std::endl << "B: " << options.specs[1] << std::endl;
+    std::cout << games << " games, A won " << totals.wins << ", drew " << totals.draws << " and lost " << totals.losses
+              << " (score " << std::fixed << std::setprecision(1) << 100 * score << "%)" << std::endl;
+    if (score > 0 && score < 1) {
+        double low = Elo(std::max(score - margin, 1e-6)), high = Elo(std::min(score + margin, 1 - 1e-6));
+        std::cout << "Elo difference: " << std::showpos << Elo(score) << std::noshowpos << " +/- " << (high - low) / 2 << std::endl;
+    } else {
+        std::cout << "Elo difference: " << (score > 0 ? "+inf" : "-inf") << std::endl;
+    }
+
+    std::cout << std::endl << std::setw(16) << "" << std::setw(14) << "A" << std::setw(14) << "B" << std::endl;
+    auto row = [&](const char *name, auto value) {
+        std::cout << std::setw(16) << std::left << name << std::right << std::setw(14) << value(totals.engines[0]) << std::setw(14) << value(totals.engines[1]) << std::endl;
+    };
+    row("moves", [](const EngineTotals &e) { return e.moves; });
+    row("average depth", [](const EngineTotals &e) { return e.moves ? double(e.depth) / e.moves : 0.0; });
+    row("nodes/s", [](const EngineTotals &e) { return e.milliseconds ? e.nodes * 1000 / e.milliseconds : 0L; });
+    row("ms per move", [](const EngineTotals &e) { return e.moves ? double(e.milliseconds) / e.moves : 0.0; });
+    row("timeouts", [](const EngineTotals &e) { return e.timeouts; });
+    row("illegal moves", [](const EngineTotals &e) { return e.illegalMoves; });
+}
+
+int main(int argc, char *argv[])
+{
+    ArenaOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-a" || arg == "-b") && i + 1 < argc) options.specs[arg == "-a" ? 0 : 1] = argv[++i];
+        else if (arg == "--games" && i + 1 < argc) options.games = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--concurrency" && i + 1 < argc) options.concurrency = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--tpm" && i + 1 < argc) options.timePerMove = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--timebank" && i + 1 < argc) options.timebank = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--opening-plies" && i + 1 < argc) options.openingPlies = std::max(0, std::stoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc) options.seed = std::stoull(argv[++i]);
+        else if (arg == "--tablebase" && i + 1 < argc) {
+            if (!Tablebase::Get().Open(argv[++i])) return 1;
+        }
+        else if (arg == "--book" && i + 1 < argc) {
+            if (!OpeningBook::Get().Open(argv[++i])) return 1;
+        }
+        else if (arg == "--verbose") options.verbose = true;
+        else {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+    for (int e = 0; e < 2; e++)
+        if (!ParseEngine(options.specs[e], options.engines[e])) return 1;
+
+    // Every game runs its engines' own search threads
+    if (!options.concurrency) {
+        int threads = std::max(options.engines[0].threads, options.engines[1].threads);
+        options.concurrency = std::max(1, (int) std::thread::hardware_concurrency() / threads);
+    }
+
+    // Only the engines log, their search output is not wanted here
+    if (!options.verbose) Logger::Get().SetLevel(LOG_LEVEL_NONE);
+
+    MatchTotals totals;
+    std::mutex mutex;
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+    for (int w = 0; w < options.concurrency; w++) {
+        workers.emplace_back([&] {
+            for (int game = next++; game < options.games; game = next++) {
+                MatchTotals result;
+                PlayGame(options, game, result);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                totals.wins += result.wins;
+                totals.draws += result.draws;
+                totals.losses += result.losses;
+                for (int e = 0; e < 2; e++) totals.engines[e].Add(result.engines[e]);
+                std::cout << "Game " << game + 1 << ": " << (result.wins ? "A wins" : result.losses ? "B wins" : "draw")
+                          << ", total +" << totals.wins << " =" << totals.draws << " -" << totals.losses << std::endl;
+            }
+        });
+    }
+    for (std::thread &worker : workers) worker.join();
+
+    Report(options, totals);
+    return 0;
+}
@@ -0,0 +1,125 @@
+// batch.cpp
+
+#include "batch.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log.h"
+#include "protocol.h"
+
+#define BATCH_QUEUE_PER_WORKER 4    // Positions read ahead, so a long input is not read into memory at once
+
+struct BatchJob {
+    long index;
+    State state;
+};
+
+// Hands out the parsed positions, the reader waits while the workers are behind
+class BatchQueue {
+    std::deque<BatchJob> jobs;
+    size_t capacity;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+public:
+    explicit BatchQueue(size_t capacity) : capacity(capacity) {}
+
+    void Push(const BatchJob &job)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return jobs.size() < capacity; });
+        jobs.push_back(job);
+        changed.notify_all();
+    }
+
+    // False once the queue is closed and empty
+    bool Pop(BatchJob &job)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return !jobs.empty() || closed; });
+        if (jobs.empty()) return false;
+        job = jobs.front();
+        jobs.pop_front();
+        changed.notify_all();
+        return true;
+    }
+
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        changed.notify_all();
+    }
+};
+
+static void analyse(BatchQueue &queue, std::ostream &output, std::mutex &outputMutex, const BatchOptions &options)
+{
+    AIOptions engine = options.engine;
+    engine.threads = 1;
+    engine.ponder = false;
+    UTTTAI ai(engine);
+
+    // Without a time limit the search only stops at the depth or node limit
+    int milliseconds = options.milliseconds ? options.milliseconds + SAFETY_MARGIN : 24 * 60 * 60 * 1000;
+    BatchJob job;
+    while (queue.Pop(job)) {
+        std::string line;
+        if (getMoves(job.state).empty()) {
+            line = "{\"index\":" + std::to_string(job.index) + ",\"error\":\"no legal moves\"}";
+        } else {
+            SearchStats stats;
+            Move move = ai.findBestMove(job.state, milliseconds, milliseconds, &stats);
+            line = "{\"index\":" + std::to_string(job.index) + ",\"move\":[" + std::to_string(move.x) + "," + std::to_string(move.y)
+                   + "]," + (stats.engine == "mcts" ? "\"winRate\":" + std::to_string(stats.winRate) : "\"score\":" + std::to_string(stats.score))
+                   + ",\"depth\":" + std::to_string(stats.depth)
+                   + ",\"nodes\":" + std::to_string(stats.nodes) + ",\"ms\":" + std::to_string(stats.milliseconds)
+                   + ",\"engine\":\"" + stats.engine + "\"}";
+        }
+        std::lock_guard<std::mutex> lock(outputMutex);
+        output << line << std::endl;
+    }
+}
+
+long analysePositions(std::istream &input, std::ostream &output, const BatchOptions &options)
+{
+    int workerCount = std::max(1, options.workers);
+    BatchQueue queue(workerCount * BATCH_QUEUE_PER_WORKER);
+    std::mutex outputMutex;
+    std::vector<std::thread> workers;
+    for (int w = 0; w < workerCount; w++) workers.emplace_back(analyse, std::ref(queue), std::ref(output), std::ref(outputMutex), std::cref(options));
+
+    // A position is complete once its macroboard follows its field
+    long count = 0;
+    bool haveField = false;
+    State state;
+    std::string line;
+    while (std::getline(input, line)) {
+        std::string_view rest = line;
+        if (nextToken(rest, ' ') != "update" || nextToken(rest, ' ') != "game") continue;
+        std::string_view key = nextToken(rest, ' ');
+        std::string_view value = nextToken(rest, ' ');
+        if (key == "field") {
+            for (int row = 0; row < 9; row++)
+                for (int col = 0; col < 9; col++)
+                    state.board[row][col] = toCell(nextToken(value, ','));
+            haveField = true;
+        } else if (key == "macroboard" && haveField) {
+            for (int row = 0; row < 3; row++)
+                for (int col = 0; col < 3; col++)
+                    state.macroboard[row][col] = toMacroCell(nextToken(value, ','));
+            queue.Push(BatchJob{count++, state});
+            haveField = false;
+        }
+    }
+
+    queue.Close();
+    for (std::thread &worker : workers) worker.join();
+    return count;
+}
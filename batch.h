@@ -0,0 +1,24 @@
+// batch.h
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <iostream>
+
+#include "utttai.h"
+
+#define DEFAULT_BATCH_MILLISECONDS 100
+
+struct BatchOptions {
+    AIOptions engine;           // Settings of every worker's engine, each searches with one thread
+    int workers = 1;
+    int milliseconds = 0;       // Time per position, 0 = only the depth or node limit of the engine
+};
+
+// Analyses the positions in input, given as the "update game field" and "update game macroboard" lines of the
+// protocol (other lines are skipped, so logs of whole games work too). The positions are spread over a pool of
+// workers and one JSON line per position is written to output as soon as it is done, tagged with the position's
+// index since they finish out of order. Returns the number of positions.
+long analysePositions(std::istream &input, std::ostream &output, const BatchOptions &options);
+
+#endif //BATCH_H
@@ -0,0 +1,100 @@
+// bitboard.cpp
+
+#include "bitboard.h"
+#include "microboards.h"
+
+BitState toBitState(const State &state)
+{
+    BitState result;
+    int count[2] = {0, 0};
+    result.active = 0;
+
+    for (int r=0; r<9; r++) {
+        for (int c=0; c<9; c++) {
+            Player p = state.board[r][c];
+            if (p != Player::X && p != Player::O) continue;
+            int index = toIndex(Move{c, r});
+            result.cells[toSide(p)][index / 9] |= 1 << (index % 9);
+            count[toSide(p)]++;
+        }
+    }
+
+    for (int b=0; b<9; b++) {
+        Player macro = state.macroboard[b / 3][b % 3];
+        if (macro == Player::X || macro == Player::O) result.won[toSide(macro)] |= 1 << b;
+        else if ((result.cells[0][b] | result.cells[1][b]) == BOARD_MASK) result.drawn |= 1 << b;
+        else if (macro == Player::Active) result.active |= 1 << b;
+    }
+    if (getWinner(result) != Player::None) result.active = 0;
+
+    result.side = count[0] > count[1] ? 1 : 0;
+    result.pieces = count[0] + count[1];
+    result.open = 0;
+    MicroboardsSummary summary = analyseMicroboards(result.cells[0], result.cells[1]);
+    for (int b=0; b<9; b++) {
+        if ((result.won[0] | result.won[1] | result.drawn) & (1 << b)) continue;
+        result.open += 9 - __builtin_popcount(result.cells[0][b] | result.cells[1][b]);
+        result.setups[0] += summary.setups[0][b];
+        result.setups[1] += summary.setups[1][b];
+    }
+    result.hash = computeHash(result);
+    return result;
+}
+
+State toState(const BitState &state)
+{
+    State result;
+    for (int i=0; i<81; i++) {
+        Move m = toMove(i);
+        if (state.cells[0][i / 9] & (1 << (i % 9))) result.board[m.y][m.x] = Player::X;
+        else if (state.cells[1][i / 9] & (1 << (i % 9))) result.board[m.y][m.x] = Player::O;
+    }
+    for (int b=0; b<9; b++) {
+        Player &macro = result.macroboard[b / 3][b % 3];
+        if (state.won[0] & (1 << b)) macro = Player::X;
+        else if (state.won[1] & (1 << b)) macro = Player::O;
+        else if (state.active & (1 << b)) macro = Player::Active;
+        else macro = Player::None;
+    }
+    return result;
+}
+
+// Computes the Zobrist hash from scratch, makeMove keeps it up to date incrementally
+uint64_t computeHash(const BitState &state)
+{
+    uint64_t hash = Zobrist::keys.active[state.active];
+    if (state.side) hash ^= Zobrist::keys.side;
+    for (int p=0; p<2; p++)
+        for (int b=0; b<9; b++)
+            for (uint16_t cells = state.cells[p][b]; cells; cells &= cells - 1)
+                hash ^= Zobrist::keys.cells[p][b * 9 + __builtin_ctz(cells)];
+    return hash;
+}
+
+Player getCurrentPlayer(const BitState &state)
+{
+    return toPlayer(state.side);
+}
+
+BitState doMove(const BitState &state, const Move &m)
+{
+    BitState result = state;
+    int index = toIndex(m);
+    Undo undo;
+
+    if (!(state.active & (1 << (index / 9))) || ((state.cells[0][index / 9] | state.cells[1][index / 9]) & (1 << (index % 9)))) {
+        return result; // Invalid move
+    }
+
+    makeMove(result, index, undo);
+    return result;
+}
+
+std::vector<Move> getMoves(const BitState &state)
+{
+    std::vector<Move> moves;
+    MoveList<int> indices;
+    getMoveIndices(state, indices);
+    for (int index : indices) moves.push_back(toMove(index));
+    return moves;
+}
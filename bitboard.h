@@ -0,0 +1,123 @@
+// bitboard.h
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+#include "uttt.h"
+#include "ttt.h"
+#include "movelist.h"
+#include "zobrist.h"
+
+#define BOARD_MASK 0x1FF
+
+// Packed position. Microboard b = (y/3)*3 + x/3 and cell c = (y%3)*3 + x%3 are both row-major,
+// so cells[p][b] bit c is square (x, y) and the nine masks of a player form its 81-bit occupancy.
+struct BitState {
+    std::array<std::array<uint16_t, 9>, 2> cells;   // [0] = X, [1] = O
+    std::array<uint16_t, 2> won;                    // Macro cells won by X / O
+    uint16_t drawn;                                 // Macro cells that are full without a winner
+    uint16_t active;                                // Macro cells the side to move may play in
+    uint8_t side;                                   // 0 = X to move, 1 = O to move
+    uint8_t pieces;                                 // Discs on the board
+    uint8_t open;                                   // Empty cells in microboards that are still undecided
+    std::array<uint8_t, 2> setups;                  // Two in a rows of X / O in microboards that are still undecided
+    uint64_t hash;                                  // Zobrist hash of discs, active boards and side to move
+
+    BitState() : cells{}, won{}, drawn(0), active(BOARD_MASK), side(0), pieces(0), open(81), setups{}, hash(Zobrist::keys.active[BOARD_MASK]) {}
+};
+
+// What makeMove overwrites and unmakeMove needs back. The won/drawn bit of the played
+// board can only have been set by the move itself, so it is cleared rather than stored.
+struct Undo {
+    uint16_t active;
+    uint8_t open;
+    std::array<uint8_t, 2> setups;
+};
+
+// Moves inside the search are plain square indices: board * 9 + cell
+inline int toIndex(const Move &m) { return (m.y / 3 * 3 + m.x / 3) * 9 + m.y % 3 * 3 + m.x % 3; }
+inline Move toMove(int index) { return Move{index / 9 % 3 * 3 + index % 3, index / 27 * 3 + index % 9 / 3}; }
+inline Player toPlayer(int side) { return side == 0 ? Player::X : Player::O; }
+inline int toSide(const Player &p) { return p == Player::X ? 0 : 1; }
+
+BitState toBitState(const State &state);
+State toState(const BitState &state);
+
+uint64_t computeHash(const BitState &state);
+Player getCurrentPlayer(const BitState &state);
+BitState doMove(const BitState &state, const Move &m);
+std::vector<Move> getMoves(const BitState &state);
+
+// What the search does at every node lives here, so it can be inlined into it
+inline Player getWinner(const BitState &state)
+{
+    return static_cast<Player>(ttt::Lookup(state.won[0], state.won[1]).winner);
+}
+
+// Plays the move at the given square index in place. The move must be legal.
+inline void makeMove(BitState &state, int index, Undo &undo)
+{
+    int board = index / 9;
+    int cell = index % 9;
+    undo.active = state.active;
+    undo.open = state.open;
+    undo.setups = state.setups;
+
+    // Only the microboard that was played into can change its status
+    const ttt::Info &before = ttt::Lookup(state.cells[0][board], state.cells[1][board]);
+    state.cells[state.side][board] |= 1 << cell;
+    state.pieces++;
+    state.open--;
+    const ttt::Info &info = ttt::Lookup(state.cells[0][board], state.cells[1][board]);
+    state.setups[0] -= before.setups[0];
+    state.setups[1] -= before.setups[1];
+    bool gameWon = false;
+    if (info.winner != static_cast<uint8_t>(Player::None)) {
+        state.won[state.side] |= 1 << board;
+        state.open -= __builtin_popcount(~(state.cells[0][board] | state.cells[1][board]) & BOARD_MASK);
+        gameWon = getWinner(state) != Player::None;
+    } else if (!info.moves) {
+        state.drawn |= 1 << board;
+    } else {
+        state.setups[0] += info.setups[0];
+        state.setups[1] += info.setups[1];
+    }
+
+    // The opponent is sent to the board matching the cell, or anywhere if that board is decided
+    uint16_t live = ~(state.won[0] | state.won[1] | state.drawn) & BOARD_MASK;
+    if (gameWon) state.active = 0;
+    else if (live & (1 << cell)) state.active = 1 << cell;
+    else state.active = live;
+
+    state.hash ^= Zobrist::keys.cells[state.side][index] ^ Zobrist::keys.active[undo.active] ^ Zobrist::keys.active[state.active] ^ Zobrist::keys.side;
+    state.side ^= 1;
+}
+
+// Takes back a move done by makeMove
+inline void unmakeMove(BitState &state, int index, const Undo &undo)
+{
+    int board = index / 9;
+    state.side ^= 1;
+    state.hash ^= Zobrist::keys.cells[state.side][index] ^ Zobrist::keys.active[undo.active] ^ Zobrist::keys.active[state.active] ^ Zobrist::keys.side;
+    state.cells[state.side][board] &= ~(1 << (index % 9));
+    state.won[state.side] &= ~(1 << board);
+    state.drawn &= ~(1 << board);
+    state.pieces--;
+    state.active = undo.active;
+    state.open = undo.open;
+    state.setups = undo.setups;
+}
+
+inline void getMoveIndices(const BitState &state, MoveList<int> &moves)
+{
+    moves.clear();
+    for (uint16_t boards = state.active; boards; boards &= boards - 1) {
+        int b = __builtin_ctz(boards);
+        uint16_t empty = ~(state.cells[0][b] | state.cells[1][b]) & BOARD_MASK;
+        for (; empty; empty &= empty - 1)
+            moves.push_back(b * 9 + __builtin_ctz(empty));
+    }
+}
+
+#endif // BITBOARD_H
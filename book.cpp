@@ -0,0 +1,103 @@
+// book.cpp
+
+#include "book.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "log.h"
+#include "symmetry.h"
+
+#define KEY_MASK (~0xFFFFULL)
+
+OpeningBook &OpeningBook::Get()
+{
+    static OpeningBook book;
+    return book;
+}
+
+bool OpeningBook::Open(const std::string &path)
+{
+    Close();
+    if (!file.Open(path, sizeof(Header))) {
+        LOG_ERROR("ERROR: Could not open opening book " << path << ".");
+        return false;
+    }
+
+    const Header *header = static_cast<const Header *>(file.Data());
+    if (header->magic != BOOK_MAGIC || header->version != BOOK_VERSION || sizeof(Header) + header->count * sizeof(uint64_t) != file.Size()) {
+        LOG_ERROR("ERROR: " << path << " is not a valid opening book.");
+        file.Close();
+        return false;
+    }
+
+    entries = reinterpret_cast<const uint64_t *>(header + 1);
+    count = header->count;
+    LOG_INFO("Loaded opening book " << path << " with " << count << " positions up to ply " << header->plies << ".");
+    return true;
+}
+
+void OpeningBook::Close()
+{
+    file.Close();
+    entries = nullptr;
+    count = 0;
+}
+
+bool OpeningBook::Probe(const BitState &state, Move &move, int &depth) const
+{
+    if (!count) return false;
+    uint64_t key;
+    int symmetry = Symmetry::CanonicalSymmetry(state, key);
+    key &= KEY_MASK;
+    const uint64_t *entry = std::lower_bound(entries, entries + count, key);
+    if (entry == entries + count || (*entry & KEY_MASK) != key) return false;
+
+    // Turn the stored move back from the canonical orientation into this one
+    int square = *entry & 0xFF;
+    if (square >= 81) return false;
+    move = toMove(Symmetry::Square(Symmetry::Inverse(symmetry), square));
+    depth = (*entry >> 8) & 0xFF;
+    return true;
+}
+
+uint64_t OpeningBook::Key(const BitState &state)
+{
+    return Symmetry::CanonicalHash(state) & KEY_MASK;
+}
+
+uint64_t OpeningBook::Key(uint64_t entry)
+{
+    return entry & KEY_MASK;
+}
+
+uint64_t OpeningBook::Pack(const BitState &state, const Move &move, int depth)
+{
+    uint64_t key;
+    int symmetry = Symmetry::CanonicalSymmetry(state, key);
+    int square = Symmetry::Square(symmetry, toIndex(move));
+    return (key & KEY_MASK) | static_cast<uint64_t>(std::min(depth, 255)) << 8 | square;
+}
+
+bool OpeningBook::Write(const std::string &path, int plies, std::vector<uint64_t> &entries)
+{
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end(), [](uint64_t a, uint64_t b) { return (a & KEY_MASK) == (b & KEY_MASK); }), entries.end());
+
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    Header header{BOOK_MAGIC, BOOK_VERSION, static_cast<uint32_t>(plies), entries.size()};
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1
+                   && std::fwrite(entries.data(), sizeof(uint64_t), entries.size(), file) == entries.size();
+    return std::fclose(file) == 0 && written;
+}
+
+std::vector<uint64_t> OpeningBook::Read(const std::string &path)
+{
+    MappedFile existing;
+    if (!existing.Open(path, sizeof(Header))) return {};
+    const Header *header = static_cast<const Header *>(existing.Data());
+    if (header->magic != BOOK_MAGIC || header->version != BOOK_VERSION || sizeof(Header) + header->count * sizeof(uint64_t) != existing.Size()) return {};
+    const uint64_t *first = reinterpret_cast<const uint64_t *>(header + 1);
+    return std::vector<uint64_t>(first, first + header->count);
+}
@@ -0,0 +1,55 @@
+// book.h
+
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bitboard.h"
+#include "mappedfile.h"
+
+#define BOOK_MAGIC 0x314B4F4254545455ULL      // "UTTTBOK1"
+#define BOOK_VERSION 1
+
+// Opening moves searched offline. Like the tablebase the file is a header and a sorted array of 64-bit entries,
+// here the top 48 bits of the canonical hash of a position, the depth it was searched to and the best move.
+// The move is stored as seen from the canonical symmetry, so one entry answers all eight orientations.
+class OpeningBook {
+    struct Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t plies;
+        uint64_t count;
+    };
+
+    MappedFile file;
+    const uint64_t *entries = nullptr;
+    size_t count = 0;
+
+    OpeningBook() = default;
+
+public:
+    static OpeningBook &Get();
+
+    bool Open(const std::string &path);
+    void Close();
+    size_t Size() const { return count; }
+
+    // Book move for the position, and the depth it was searched to
+    bool Probe(const BitState &state, Move &move, int &depth) const;
+
+    // Key of a position, the same for all its orientations, and the key an entry belongs to
+    static uint64_t Key(const BitState &state);
+    static uint64_t Key(uint64_t entry);
+    // Entry saying the move was found best in the position by a search of the given depth
+    static uint64_t Pack(const BitState &state, const Move &move, int depth);
+    // Sorts the entries and writes them, returns whether that worked
+    static bool Write(const std::string &path, int plies, std::vector<uint64_t> &entries);
+    // Entries of an existing book file, empty when there is none
+    static std::vector<uint64_t> Read(const std::string &path);
+};
+
+#endif //BOOK_H
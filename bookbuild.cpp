@@ -0,0 +1,103 @@
+// bookbuild.cpp
+// Builds an opening book. Every position up to the given ply is searched once per symmetry class, for as long
+// as it is given, and its best move is stored. The book is rewritten after every position, so a build can
+// be stopped at any time and continues where it left off when started again with the same output file.
+//
+// bookbuild [--plies N] [--seconds S] [--threads N] [--hash MB] [--out file] [--verbose]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "bitboard.h"
+#include "book.h"
+#include "log.h"
+#include "symmetry.h"
+#include "utttai.h"
+
+#define DEFAULT_BOOK_PLIES 2
+#define DEFAULT_BOOK_SECONDS 10
+#define DEFAULT_BOOK_HASH_MB 256
+#define DEFAULT_BOOK_FILE "opening.book"
+
+// One position of every symmetry class reachable in at most the given number of moves, by ply
+static std::vector<BitState> OpeningPositions(int plies)
+{
+    std::vector<BitState> positions{BitState()}, level{BitState()};
+    std::unordered_set<uint64_t> seen{Symmetry::CanonicalHash(BitState())};
+    for (int ply = 1; ply <= plies; ply++) {
+        std::vector<BitState> next;
+        for (const BitState &position : level) {
+            MoveList<int> moves;
+            getMoveIndices(position, moves);
+            for (int move : moves) {
+                BitState child = position;
+                Undo undo;
+                makeMove(child, move, undo);
+                if (getWinner(child) != Player::None || !seen.insert(Symmetry::CanonicalHash(child)).second) continue;
+                next.push_back(child);
+            }
+        }
+        positions.insert(positions.end(), next.begin(), next.end());
+        level.swap(next);
+    }
+    return positions;
+}
+
+int main(int argc, char *argv[])
+{
+    int plies = DEFAULT_BOOK_PLIES;
+    int seconds = DEFAULT_BOOK_SECONDS;
+    AIOptions options;
+    options.threads = std::max(1, (int) std::thread::hardware_concurrency());
+    options.hashMegabytes = DEFAULT_BOOK_HASH_MB;
+    options.seed = 1;
+    std::string out = DEFAULT_BOOK_FILE;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--plies" && i + 1 < argc) plies = std::max(0, std::stoi(argv[++i]));
+        else if (arg == "--seconds" && i + 1 < argc) seconds = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) options.threads = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--hash" && i + 1 < argc) options.hashMegabytes = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--out" && i + 1 < argc) out = argv[++i];
+        else if (arg == "--verbose") verbose = true;
+        else {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (!verbose) Logger::Get().SetLevel(LOG_LEVEL_WARN);
+
+    std::vector<BitState> positions = OpeningPositions(plies);
+    std::vector<uint64_t> entries = OpeningBook::Read(out);
+    std::unordered_set<uint64_t> known;
+    for (uint64_t entry : entries) known.insert(OpeningBook::Key(entry));
+    std::cout << positions.size() << " positions up to ply " << plies << ", " << known.size() << " already in " << out << "." << std::endl;
+
+    UTTTAI ai(options);
+    auto start = std::chrono::steady_clock::now();
+    int milliseconds = seconds * 1000;
+    for (size_t i = 0; i < positions.size(); i++) {
+        const BitState &position = positions[i];
+        if (known.count(OpeningBook::Key(position))) continue;
+
+        SearchStats stats;
+        Move move = ai.findBestMove(toState(position), milliseconds, milliseconds, &stats);
+        entries.push_back(OpeningBook::Pack(position, move, stats.depth));
+        if (!OpeningBook::Write(out, plies, entries)) {
+            std::cout << "Could not write " << out << "." << std::endl;
+            return 1;
+        }
+        std::cout << "Position " << i + 1 << " of " << positions.size() << " (ply " << (int) position.pieces << "): " << move
+                  << " at depth " << stats.depth << std::endl;
+    }
+
+    long elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Wrote " << entries.size() << " positions to " << out << " in " << elapsed << " s." << std::endl;
+    return 0;
+}
@@ -0,0 +1,43 @@
+// endgame.cpp
+
+#include "endgame.h"
+#include "symmetry.h"
+
+EndgameValue EndgameValue::Parent() const
+{
+    switch (outcome) {
+        case Outcome::Win: return EndgameValue{Outcome::Loss, static_cast<uint8_t>(distance + 1)};
+        case Outcome::Loss: return EndgameValue{Outcome::Win, static_cast<uint8_t>(distance + 1)};
+        default: return EndgameValue{Outcome::Draw, 0};
+    }
+}
+
+EndgameValue EndgameSolver::Solve(BitState &state)
+{
+    // The side that just moved may have won; otherwise a position without moves is a draw
+    if (getWinner(state) != Player::None) return EndgameValue{Outcome::Loss, 0};
+    MoveList<int> moves;
+    getMoveIndices(state, moves);
+    if (moves.empty()) return EndgameValue{Outcome::Draw, 0};
+
+    uint64_t key = Symmetry::CanonicalHash(state);
+    auto known = solved.find(key);
+    if (known != solved.end()) return known->second;
+
+    EndgameValue best{Outcome::Loss, 0};
+    int bestScore = -1000;
+    Undo undo;
+    for (int move : moves) {
+        makeMove(state, move, undo);
+        EndgameValue value = Solve(state).Parent();
+        unmakeMove(state, move, undo);
+        if (value.Score() > bestScore) {
+            best = value;
+            bestScore = value.Score();
+        }
+        if (value.outcome == Outcome::Win && value.distance == 1) break;    // Nothing beats winning right away
+    }
+
+    solved.emplace(key, best);
+    return best;
+}
@@ -0,0 +1,37 @@
+// endgame.h
+
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "bitboard.h"
+
+#define DEFAULT_ENDGAME_EMPTY 12    // Positions with at most this many open cells count as endgames
+
+enum class Outcome : uint8_t { Loss, Draw, Win };
+
+// Exact result of a position for the side to move. Distance is the number of moves until the game ends
+// with best play: the winner takes the shortest route, the loser the longest. Draws have distance 0.
+struct EndgameValue {
+    Outcome outcome;
+    uint8_t distance;
+
+    // Orders values from the point of view of the side to move, higher is better
+    int Score() const { return outcome == Outcome::Win ? 256 - distance : outcome == Outcome::Loss ? distance - 256 : 0; }
+    // Value of the parent position, for the side that moved into this one
+    EndgameValue Parent() const;
+};
+
+// Solves endgames exactly by searching them to the end. Every position it solves is remembered by its
+// canonical hash, which the tablebase builder collects afterwards.
+class EndgameSolver {
+    std::unordered_map<uint64_t, EndgameValue> solved;
+
+public:
+    EndgameValue Solve(BitState &state);
+    const std::unordered_map<uint64_t, EndgameValue> &Solved() const { return solved; }
+};
+
+#endif //ENDGAME_H
@@ -0,0 +1,48 @@
+// fastrandom.h
+
+#ifndef FASTRANDOM_H
+#define FASTRANDOM_H
+
+#include <cstdint>
+
+// xorshift64* generator. Much cheaper than std::mt19937 with a distribution, which matters
+// when thousands of random games are played per move.
+class FastRandom {
+    uint64_t state;
+
+public:
+    explicit FastRandom(uint64_t seed = 0x2545F4914F6CDD1DULL) : state(seed ? seed : 0x2545F4914F6CDD1DULL) {}
+
+    uint64_t Next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+
+    // Uniform in [0, n) without a division
+    uint32_t Below(uint32_t n)
+    {
+        return static_cast<uint32_t>(((Next() >> 32) * n) >> 32);
+    }
+};
+
+// splitmix64 over a counter. Every number is a hash of its own counter value instead of the previous
+// number, so numbers for independent games played side by side do not wait on one another.
+class CounterRandom {
+    uint64_t counter;
+
+public:
+    explicit CounterRandom(uint64_t seed = 0) : counter(seed) {}
+
+    uint64_t Next()
+    {
+        uint64_t z = counter += 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+#endif //FASTRANDOM_H
@@ -0,0 +1,108 @@
+// log.cpp
+
+#include "log.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#define LOG_IDLE_SLEEP 2            // Milliseconds the writer sleeps when there is nothing to write
+
+Logger::Logger()
+{
+    for (size_t i = 0; i < LOG_RING_SIZE; i++) {
+        lines[i].sequence.store(i, std::memory_order_relaxed);
+        lines[i].spilled = nullptr;
+    }
+    writer = std::thread(&Logger::Write, this);
+}
+
+// Runs at exit, after main returned: everything still in the ring gets written
+Logger::~Logger()
+{
+    stopping = true;
+    writer.join();
+}
+
+Logger &Logger::Get()
+{
+    static Logger logger;
+    return logger;
+}
+
+// Bounded multi-producer queue: a line may be filled once its sequence equals the claimed position,
+// and may be printed once the sequence is one past it
+void Logger::Push(const char *text, size_t length)
+{
+    size_t position = head.load(std::memory_order_relaxed);
+    Line *line;
+    for (;;) {
+        line = &lines[position & (LOG_RING_SIZE - 1)];
+        size_t sequence = line->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+        if (difference == 0) {
+            if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+        } else if (difference < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            position = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    line->length = length;
+    line->spilled = length > LOG_LINE_SIZE ? new char[length] : nullptr;
+    std::memcpy(line->spilled ? line->spilled : line->text, text, length);
+    line->sequence.store(position + 1, std::memory_order_release);
+}
+
+// Writes every line that is ready, returns whether there were any
+bool Logger::Drain()
+{
+    bool wrote = false;
+    for (;;) {
+        Line &line = lines[tail & (LOG_RING_SIZE - 1)];
+        if (line.sequence.load(std::memory_order_acquire) != tail + 1) break;
+        std::fwrite(line.spilled ? line.spilled : line.text, 1, line.length, stderr);
+        delete[] line.spilled;
+        line.spilled = nullptr;
+        line.sequence.store(tail + LOG_RING_SIZE, std::memory_order_release);
+        tail++;
+        wrote = true;
+    }
+
+    long lost = dropped.exchange(0, std::memory_order_relaxed);
+    if (lost) std::fprintf(stderr, "Log ring was full, dropped %ld line(s).\n", lost);
+    if (wrote || lost) std::fflush(stderr);
+    return wrote;
+}
+
+void Logger::Write()
+{
+    for (;;) {
+        bool stop = stopping.load();
+        if (!Drain()) {
+            if (stop) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(LOG_IDLE_SLEEP));
+        }
+    }
+}
+
+int LogLine::overflow(int c)
+{
+    spilled.append(buffer, pptr() - buffer);
+    setp(buffer, buffer + LOG_LINE_SIZE - 1);
+    if (c != std::streambuf::traits_type::eof()) sputc(std::streambuf::traits_type::to_char_type(c));
+    return std::streambuf::traits_type::not_eof(c);
+}
+
+LogLine::~LogLine()
+{
+    *pptr() = '\n';
+    if (spilled.empty()) {
+        Logger::Get().Push(buffer, pptr() - buffer + 1);
+    } else {
+        spilled.append(buffer, pptr() - buffer + 1);
+        Logger::Get().Push(spilled.data(), spilled.size());
+    }
+}
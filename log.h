@@ -0,0 +1,89 @@
+// log.h
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+// Least severe level that is compiled in, anything below it costs nothing at all
+#ifndef UTTT_LOG_LEVEL
+#ifdef NDEBUG
+#define UTTT_LOG_LEVEL LOG_LEVEL_INFO
+#else
+#define UTTT_LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+#define LOG_RING_SIZE 256           // Lines waiting to be written, power of two
+#define LOG_LINE_SIZE 2048          // Longer lines are rare and go to the heap whole
+
+// Lines are formatted on the caller's stack and handed to a fixed ring buffer, which a background
+// thread writes to stderr. Logging never waits: when the ring is full the line is dropped and counted
+// instead. It only allocates for a line longer than LOG_LINE_SIZE, which is kept whole on the heap
+// rather than cut off, since such lines are usually JSON that has to stay parseable.
+class Logger {
+    struct Line {
+        std::atomic<size_t> sequence;
+        size_t length;
+        char *spilled;              // Copy of a line too long for text, freed once written
+        char text[LOG_LINE_SIZE];
+    };
+
+    Line lines[LOG_RING_SIZE];
+    alignas(64) std::atomic<size_t> head{0};    // Next line to write into
+    alignas(64) size_t tail = 0;                // Next line to print, only touched by the writer
+    std::atomic<long> dropped{0};
+    std::atomic<int> level{LOG_LEVEL_DEBUG};
+    std::atomic<bool> stopping{false};
+    std::thread writer;
+
+    Logger();
+    ~Logger();
+    void Write();
+    bool Drain();
+
+public:
+    static Logger &Get();
+
+    // Runtime filter on top of UTTT_LOG_LEVEL
+    void SetLevel(int minimum) { level.store(minimum, std::memory_order_relaxed); }
+    int Level() const { return level.load(std::memory_order_relaxed); }
+    bool Enabled(int severity) const { return severity >= level.load(std::memory_order_relaxed); }
+
+    void Push(const char *text, size_t length);
+};
+
+// Formats one line into a buffer on the stack and pushes it when it goes out of scope. A line that outgrows
+// the buffer is moved to a string, the buffer then collects the next part.
+class LogLine : private std::streambuf, public std::ostream {
+    char buffer[LOG_LINE_SIZE];
+    std::string spilled;
+
+    int overflow(int c) override;
+
+public:
+    LogLine() : std::ostream(this) { setp(buffer, buffer + LOG_LINE_SIZE - 1); }
+    ~LogLine() override;
+};
+
+#define UTTT_LOG(severity, message) \
+    do { if ((severity) >= UTTT_LOG_LEVEL && Logger::Get().Enabled(severity)) { LogLine line_; line_ << message; } } while (0)
+
+#define LOG_DEBUG(message) UTTT_LOG(LOG_LEVEL_DEBUG, message)
+#define LOG_INFO(message) UTTT_LOG(LOG_LEVEL_INFO, message)
+#define LOG_WARN(message) UTTT_LOG(LOG_LEVEL_WARN, message)
+#define LOG_ERROR(message) UTTT_LOG(LOG_LEVEL_ERROR, message)
+
+#endif //LOG_H
@@ -2,7 +2,14 @@
 // Jeffrey Drost
 
 #include "utttbot.h"
+#include "batch.h"
+#include "server.h"
+#include "log.h"
 #include <vector>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
 
 void test()
 {
@@ -25,10 +32,83 @@ void test()
         bot.input(input[i]);
 }
 
-int main() {
+int main(int argc, char *argv[]) {
     //test();
 
-	UTTTBot bot;
+	AIOptions options;
+	std::string batchInput;
+	bool server = false;
+	int workers = 0, movetime = -1;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--hash" && i + 1 < argc) options.hashMegabytes = std::stoi(argv[++i]);
+		else if (arg == "--threads" && i + 1 < argc) options.threads = std::max(1, std::stoi(argv[++i]));
+		else if (arg == "--ponder") options.ponder = true;
+		else if (arg == "--stats-json") options.statsJson = true;
+		else if (arg == "--tablebase" && i + 1 < argc) Tablebase::Get().Open(argv[++i]);
+		else if (arg == "--book" && i + 1 < argc) OpeningBook::Get().Open(argv[++i]);
+		else if (arg == "--engine" && i + 1 < argc) {
+			std::string engine = argv[++i];
+			if (engine == "mcts") options.engine = Engine::MCTS;
+			else if (engine == "minimax") options.engine = Engine::Minimax;
+			else LOG_WARN("Unknown engine: " << engine);
+		}
+		else if (arg == "--mcts-mb" && i + 1 < argc) options.mctsMegabytes = std::max(1, std::stoi(argv[++i]));
+		else if (arg == "--nodes" && i + 1 < argc) options.nodesPerMove = std::max(0L, std::stol(argv[++i]));
+		else if (arg == "--depth" && i + 1 < argc) options.maxDepth = std::max(0, std::stoi(argv[++i]));
+		else if (arg == "--proof-share" && i + 1 < argc) options.proofShare = std::max(0, std::min(100, std::stoi(argv[++i])));
+		else if (arg == "--proof-mb" && i + 1 < argc) options.proofMegabytes = std::max(1, std::stoi(argv[++i]));
+		else if (arg == "--batch" && i + 1 < argc) batchInput = argv[++i];
+		else if (arg == "--server") server = true;
+		else if (arg == "--workers" && i + 1 < argc) workers = std::max(1, std::stoi(argv[++i]));
+		else if (arg == "--movetime" && i + 1 < argc) movetime = std::max(0, std::stoi(argv[++i]));
+		else LOG_WARN("Unknown argument: " << arg);
+	}
+
+	if (options.engine == Engine::MCTS && options.maxDepth) LOG_WARN("The MCTS engine has no search depth, --depth is ignored.");
+
+	// Batch analysis of a file of positions ("-" for stdin) instead of playing a game
+	if (!batchInput.empty()) {
+		// MCTS only stops at the clock or the playout limit
+		bool limited = options.nodesPerMove || (options.engine == Engine::Minimax && options.maxDepth);
+		BatchOptions batch;
+		batch.engine = options;
+		batch.workers = workers ? workers : std::max(1, (int) std::thread::hardware_concurrency());
+		batch.milliseconds = movetime >= 0 ? movetime : limited ? 0 : DEFAULT_BATCH_MILLISECONDS;
+		if (!batch.milliseconds && !limited) {
+			LOG_ERROR("ERROR: --movetime 0 needs a limit that ends the search, --nodes" << (options.engine == Engine::MCTS ? "" : " or --depth") << ".");
+			return 1;
+		}
+		std::ifstream file;
+		if (batchInput != "-") {
+			file.open(batchInput);
+			if (!file) {
+				LOG_ERROR("ERROR: Could not open " << batchInput << ".");
+				return 1;
+			}
+		}
+
+		int level = Logger::Get().Level();
+		Logger::Get().SetLevel(std::max(level, LOG_LEVEL_WARN));     // Per-search logging would swamp the results
+		auto start = std::chrono::steady_clock::now();
+		long count = analysePositions(batchInput == "-" ? std::cin : file, std::cout, batch);
+		long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		Logger::Get().SetLevel(level);
+		LOG_INFO("Analysed " << count << " positions in " << elapsed << " ms with " << batch.workers << " worker(s), "
+				 << (elapsed ? count * 1000.0 / elapsed : 0) << " positions per second.");
+		return 0;
+	}
+
+	// Many games over stdin, every line prefixed with the id of its game
+	if (server) {
+		ServerOptions serverOptions;
+		serverOptions.engine = options;
+		serverOptions.workers = workers ? workers : std::max(1, (int) std::thread::hardware_concurrency());
+		UTTTServer(serverOptions).run();
+		return 0;
+	}
+
+	UTTTBot bot(options);
 	bot.run();
 
 	return 0;
@@ -0,0 +1,32 @@
+// mappedfile.cpp
+
+#include "mappedfile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MappedFile::Open(const std::string &path, size_t minimumSize)
+{
+    Close();
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) return false;
+    struct stat info{};
+    fstat(file, &info);
+    size_t length = info.st_size;
+    void *mapping = length >= minimumSize && length > 0 ? mmap(nullptr, length, PROT_READ, MAP_SHARED, file, 0) : MAP_FAILED;
+    close(file);
+    if (mapping == MAP_FAILED) return false;
+
+    data = mapping;
+    size = length;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data) munmap(data, size);
+    data = nullptr;
+    size = 0;
+}
@@ -0,0 +1,28 @@
+// mappedfile.h
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// A whole file mapped read-only into memory. Pages are loaded on first touch and shared with every other
+// process that maps the same file, so even large tables open instantly.
+class MappedFile {
+    void *data = nullptr;
+    size_t size = 0;
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() { Close(); }
+
+    // Returns whether the file could be mapped, files smaller than minimumSize count as failures
+    bool Open(const std::string &path, size_t minimumSize);
+    void Close();
+    const void *Data() const { return data; }
+    size_t Size() const { return size; }
+};
+
+#endif //MAPPEDFILE_H
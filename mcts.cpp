@@ -0,0 +1,183 @@
+// mcts.cpp
+
+#include "mcts.h"
+
+#include <cmath>
+
+#include "TreeSearch.h"
+#include "log.h"
+
+MCTS::MCTS(int megabytes, uint64_t seed) : random(seed), playout(seed)
+{
+    size_t count = static_cast<size_t>(megabytes) * 1024 * 1024 / sizeof(Node) / 2;
+    nodes.resize(count);
+    spare.resize(count);
+}
+
+// Looks for the given position among the positions one or two moves (ours and the opponent's) below the
+// current root. If it is there that subtree becomes the new tree, compacted at the front of the spare arena.
+bool MCTS::Reroot(const BitState &state)
+{
+    if (!used) return false;
+
+    uint32_t found = 0;
+    const Node &root = nodes[0];
+    for (uint32_t c = root.firstChild; c && c < root.firstChild + root.childCount && !found; c++) {
+        BitState child = rootState;
+        Undo undo;
+        makeMove(child, nodes[c].move, undo);
+        if (child.hash == state.hash && child.cells == state.cells) found = c;
+
+        const Node &node = nodes[c];
+        for (uint32_t g = node.firstChild; g && g < node.firstChild + node.childCount && !found; g++) {
+            BitState grandchild = child;
+            makeMove(grandchild, nodes[g].move, undo);
+            if (grandchild.hash == state.hash && grandchild.cells == state.cells) found = g;
+        }
+    }
+    if (!found) return false;
+
+    // Breadth first copy, every node's children are copied as one block
+    uint32_t copied = 1;
+    spare[0] = nodes[found];
+    for (uint32_t i = 0; i < copied; i++) {
+        Node &node = spare[i];
+        if (!node.firstChild) continue;
+        for (int c = 0; c < node.childCount; c++) spare[copied + c] = nodes[node.firstChild + c];
+        node.firstChild = copied;
+        copied += node.childCount;
+    }
+    nodes.swap(spare);
+    used = copied;
+    rootState = state;
+    return true;
+}
+
+// Adds all children of a node, returns the index of the first one or 0 when there are none
+// (the game is over, or the arena is full)
+uint32_t MCTS::Expand(uint32_t index, const BitState &state)
+{
+    MoveList<int> moves;
+    getMoveIndices(state, moves);
+    if (moves.empty() || used + moves.size() > nodes.size()) return 0;
+
+    uint32_t first = used;
+    for (int move : moves) nodes[used++] = Node{0, 0, static_cast<uint8_t>(move), 0, 0.0f};
+    nodes[index].firstChild = first;
+    nodes[index].childCount = moves.size();
+    return first;
+}
+
+// UCT: the child with the best upper confidence bound, children that were never visited first
+uint32_t MCTS::Select(const Node &parent) const
+{
+    float logVisits = std::log(static_cast<float>(parent.visits));
+    uint32_t best = parent.firstChild;
+    float bestValue = -1.0f;
+    for (uint32_t c = parent.firstChild; c < parent.firstChild + parent.childCount; c++) {
+        const Node &child = nodes[c];
+        if (!child.visits) return c;
+        float value = child.score / child.visits + UCT_EXPLORATION * std::sqrt(logVisits / child.visits);
+        if (value > bestValue) {
+            bestValue = value;
+            best = c;
+        }
+    }
+    return best;
+}
+
+// Plays random moves until the game ends, returns the result for the given side
+float MCTS::Playout(const BitState &state, int side)
+{
+    int winner = playout.Play(state);
+    if (winner < 0) return 0.5f;
+    return winner == side ? 1.0f : 0.0f;
+}
+
+Move MCTS::FindBestMove(const BitState &state, std::chrono::steady_clock::time_point deadline, long playoutLimit)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    bool kept = Reroot(state);
+    if (!kept) {
+        rootState = state;
+        nodes[0] = Node{0, 0, 0, 0, 0.0f};
+        used = 1;
+    }
+    uint32_t keptVisits = nodes[0].visits;
+    // The root always gets its children, a kept tree that leaves no room for them is dropped
+    if (!nodes[0].firstChild && !Expand(0, rootState) && used > 1) {
+        nodes[0] = Node{0, 0, 0, 0, 0.0f};
+        used = 1;
+        Expand(0, rootState);
+    }
+
+    long playouts = 0;
+    int maxDepth = 0;
+    uint32_t path[MAX_PLY + 2];
+    int movers[MAX_PLY + 2];
+    // At least one playout, however late the search starts
+    while ((!playoutLimit || playouts < playoutLimit) && (!playouts || (playouts & 63) || std::chrono::steady_clock::now() < deadline)) {
+        BitState current = rootState;
+        Undo undo;
+        uint32_t index = 0;
+        int length = 0;
+        path[length] = 0;
+        movers[length++] = current.side ^ 1;
+
+        // Selection
+        while (nodes[index].firstChild) {
+            index = Select(nodes[index]);
+            movers[length] = current.side;
+            path[length++] = index;
+            makeMove(current, nodes[index].move, undo);
+        }
+
+        // Expansion, a leaf gets its children on its second visit
+        if (index == 0 || nodes[index].visits > 0) {
+            uint32_t first = Expand(index, current);
+            if (first) {
+                index = first + random.Below(nodes[index].childCount);
+                movers[length] = current.side;
+                path[length++] = index;
+                makeMove(current, nodes[index].move, undo);
+            }
+        }
+
+        maxDepth = std::max(maxDepth, length - 1);
+
+        // Simulation and backpropagation, results are from X's perspective
+        float result = Playout(current, 0);
+        for (int i = 0; i < length; i++) {
+            Node &node = nodes[path[i]];
+            node.visits++;
+            node.score += movers[i] == 0 ? result : 1.0f - result;
+        }
+        playouts++;
+    }
+
+    // Without children (the arena is full) any legal move is better than none
+    const Node &root = nodes[0];
+    if (!root.firstChild) {
+        MoveList<int> moves;
+        getMoveIndices(rootState, moves);
+        LOG_ERROR("ERROR: MCTS could not expand the root, playing a random move.");
+        lastPlayouts = playouts;
+        lastDepth = 0;
+        return moves.empty() ? Move{-1, -1} : toMove(moves[random.Below(moves.size())]);
+    }
+    uint32_t best = root.firstChild;
+    for (uint32_t c = root.firstChild; c < root.firstChild + root.childCount; c++)
+        if (nodes[c].visits > nodes[best].visits) best = c;
+
+    lastPlayouts = playouts;
+    lastWinRate = nodes[best].visits ? nodes[best].score / nodes[best].visits : 0.5f;
+    lastDepth = maxDepth;
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+    LOG_INFO("MCTS: " << playouts << " playouts in " << elapsed << " ms (" << playouts * 1000 / std::max(elapsed, 1L) << " per second)"
+              << (kept ? ", reused " + std::to_string(keptVisits) + " visits" : "") << ".");
+    LOG_INFO("MCTS: tree holds " << used << " of " << nodes.size() << " nodes (" << used * sizeof(Node) / (1024 * 1024) << " of "
+              << 2 * nodes.size() * sizeof(Node) / (1024 * 1024) << " MB), best move won " << nodes[best].score / std::max(nodes[best].visits, 1u) * 100
+              << "% of " << nodes[best].visits << " visits.");
+
+    return toMove(nodes[best].move);
+}
@@ -0,0 +1,55 @@
+// mcts.h
+
+#ifndef MCTS_H
+#define MCTS_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "bitboard.h"
+#include "fastrandom.h"
+#include "playout.h"
+
+#define DEFAULT_MCTS_MEGABYTES 64
+#define UCT_EXPLORATION 1.4f
+
+// Monte Carlo tree search with UCT selection and random playouts. Nodes live in a pre-allocated arena,
+// the children of a node are stored next to each other. The part of the tree below the moves that
+// were actually played is kept for the next turn.
+class MCTS {
+    struct Node {
+        uint32_t firstChild;    // 0 while not expanded, the root is the only node at index 0
+        uint8_t childCount;
+        uint8_t move;           // Square index of the move leading here
+        uint32_t visits;
+        float score;            // Sum of results for the player who made the move: 1 win, 0.5 draw
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Node> spare;    // Second arena, the kept subtree is compacted into it when re-rooting
+    uint32_t used = 0;
+    BitState rootState;
+    FastRandom random;
+    PlayoutKernel playout;
+    long lastPlayouts = 0;
+    float lastWinRate = 0.5f;
+    int lastDepth = 0;
+
+    bool Reroot(const BitState &state);
+    uint32_t Expand(uint32_t index, const BitState &state);
+    uint32_t Select(const Node &parent) const;
+    float Playout(const BitState &state, int side);
+
+public:
+    explicit MCTS(int megabytes = DEFAULT_MCTS_MEGABYTES, uint64_t seed = 1);
+
+    // Searches until the deadline, or until playoutLimit (0 = none) playouts were played
+    Move FindBestMove(const BitState &state, std::chrono::steady_clock::time_point deadline, long playoutLimit = 0);
+    long LastPlayouts() const { return lastPlayouts; }
+    float LastWinRate() const { return lastWinRate; }  // Share of the chosen move's playouts it won, draws count half
+    int LastDepth() const { return lastDepth; }      // Deepest node reached by the selection
+    long LastTreeNodes() const { return used; }
+};
+
+#endif //MCTS_H
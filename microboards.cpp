@@ -0,0 +1,217 @@
+// microboards.cpp
+
+#include "microboards.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MICROBOARDS_X86
+#endif
+
+#define BOARD_LANES 16      // Nine boards padded to a whole number of vectors
+#define BOARD_CELLS 0x1FF
+
+static constexpr uint16_t winLines[8] = {
+        0x007, 0x038, 0x1C0,    // Horizontal
+        0x049, 0x092, 0x124,    // Vertical
+        0x111, 0x054            // Diagonal
+};
+
+// Each line with one of its cells taken out, a player has two in a row when its cells on the line equal one of these
+struct LinePairs {
+    uint16_t pairs[8][3];
+};
+
+static constexpr LinePairs BuildPairs()
+{
+    LinePairs result{};
+    for (int l = 0; l < 8; l++) {
+        int p = 0;
+        for (int cell = 0; cell < 9; cell++)
+            if (winLines[l] & (1 << cell)) result.pairs[l][p++] = winLines[l] & ~(1 << cell);
+    }
+    return result;
+}
+
+static constexpr LinePairs linePairs = BuildPairs();
+
+static MicroboardsSummary AnalyseScalar(const std::array<uint16_t, 9> &x, const std::array<uint16_t, 9> &o)
+{
+    MicroboardsSummary summary{};
+    for (int b = 0; b < 9; b++) {
+        for (int l = 0; l < 8; l++) {
+            uint16_t line = winLines[l], xl = x[b] & line, ol = o[b] & line;
+            if (xl == line) summary.won[0] |= 1 << b;
+            if (ol == line) summary.won[1] |= 1 << b;
+            if (!ol) summary.openLines[0][b]++;
+            if (!xl) summary.openLines[1][b]++;
+            const uint16_t *pairs = linePairs.pairs[l];
+            if (!ol && (xl == pairs[0] || xl == pairs[1] || xl == pairs[2])) summary.setups[0][b]++;
+            if (!xl && (ol == pairs[0] || ol == pairs[1] || ol == pairs[2])) summary.setups[1][b]++;
+        }
+        if ((x[b] | o[b]) == BOARD_CELLS) summary.full |= 1 << b;
+    }
+    return summary;
+}
+
+#ifdef MICROBOARDS_X86
+
+// Compare results of boards 0-7 and 8-15, each lane -1 (all bits set) for true or a count
+struct Lanes {
+    __m128i low, high;
+};
+
+// Inlined, so the AVX2 kernel runs them as VEX code rather than switching back to SSE
+#define LANES_INLINE inline __attribute__((always_inline))
+
+// Narrows the lanes to bytes, so a byte mask gives one bit per board and the counts can be copied as they are
+static LANES_INLINE uint16_t BoardMask(const Lanes &lanes)
+{
+    return _mm_movemask_epi8(_mm_packs_epi16(lanes.low, lanes.high)) & BOARD_CELLS;
+}
+
+static LANES_INLINE void StoreCounts(const Lanes &lanes, std::array<uint8_t, 9> &counts)
+{
+    alignas(16) uint8_t bytes[BOARD_LANES];
+    _mm_store_si128(reinterpret_cast<__m128i *>(bytes), _mm_packus_epi16(lanes.low, lanes.high));
+    std::memcpy(counts.data(), bytes, counts.size());
+}
+
+static LANES_INLINE MicroboardsSummary Summarise(const Lanes &wonX, const Lanes &wonO, const Lanes &full, const Lanes &openX, const Lanes &openO, const Lanes &setupsX, const Lanes &setupsO)
+{
+    MicroboardsSummary summary;
+    summary.won[0] = BoardMask(wonX);
+    summary.won[1] = BoardMask(wonO);
+    summary.full = BoardMask(full);
+    StoreCounts(openX, summary.openLines[0]);
+    StoreCounts(openO, summary.openLines[1]);
+    StoreCounts(setupsX, summary.setups[0]);
+    StoreCounts(setupsO, summary.setups[1]);
+    return summary;
+}
+
+// Eight boards per vector, counters go down by one for every true compare (-1)
+static LANES_INLINE void AnalyseSSE2(__m128i X, __m128i O, __m128i &wonX, __m128i &wonO, __m128i &full, __m128i &openX, __m128i &openO, __m128i &setupsX, __m128i &setupsO)
+{
+    __m128i zero = _mm_setzero_si128();
+    wonX = wonO = openX = openO = setupsX = setupsO = zero;
+    full = _mm_cmpeq_epi16(_mm_or_si128(X, O), _mm_set1_epi16(BOARD_CELLS));
+    for (int l = 0; l < 8; l++) {
+        __m128i line = _mm_set1_epi16(winLines[l]);
+        __m128i xl = _mm_and_si128(X, line), ol = _mm_and_si128(O, line);
+        __m128i noX = _mm_cmpeq_epi16(xl, zero), noO = _mm_cmpeq_epi16(ol, zero);
+        wonX = _mm_or_si128(wonX, _mm_cmpeq_epi16(xl, line));
+        wonO = _mm_or_si128(wonO, _mm_cmpeq_epi16(ol, line));
+        openX = _mm_sub_epi16(openX, noO);
+        openO = _mm_sub_epi16(openO, noX);
+        __m128i twoX = zero, twoO = zero;
+        for (int p = 0; p < 3; p++) {
+            __m128i pair = _mm_set1_epi16(linePairs.pairs[l][p]);
+            twoX = _mm_or_si128(twoX, _mm_cmpeq_epi16(xl, pair));
+            twoO = _mm_or_si128(twoO, _mm_cmpeq_epi16(ol, pair));
+        }
+        setupsX = _mm_sub_epi16(setupsX, _mm_and_si128(twoX, noO));
+        setupsO = _mm_sub_epi16(setupsO, _mm_and_si128(twoO, noX));
+    }
+}
+
+static MicroboardsSummary AnalyseSSE2(const uint16_t *x, const uint16_t *o)
+{
+    const __m128i *xs = reinterpret_cast<const __m128i *>(x), *os = reinterpret_cast<const __m128i *>(o);
+    Lanes wonX, wonO, full, openX, openO, setupsX, setupsO;
+    AnalyseSSE2(_mm_load_si128(xs), _mm_load_si128(os), wonX.low, wonO.low, full.low, openX.low, openO.low, setupsX.low, setupsO.low);
+    AnalyseSSE2(_mm_load_si128(xs + 1), _mm_load_si128(os + 1), wonX.high, wonO.high, full.high, openX.high, openO.high, setupsX.high, setupsO.high);
+    return Summarise(wonX, wonO, full, openX, openO, setupsX, setupsO);
+}
+
+__attribute__((target("avx2")))
+static LANES_INLINE Lanes Split(__m256i v)
+{
+    return Lanes{_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)};
+}
+
+// All nine boards in one vector
+__attribute__((target("avx2")))
+static MicroboardsSummary AnalyseAVX2(const uint16_t *x, const uint16_t *o)
+{
+    __m256i X = _mm256_load_si256(reinterpret_cast<const __m256i *>(x));
+    __m256i O = _mm256_load_si256(reinterpret_cast<const __m256i *>(o));
+    __m256i zero = _mm256_setzero_si256();
+    __m256i wonX = zero, wonO = zero, openX = zero, openO = zero, setupsX = zero, setupsO = zero;
+    __m256i full = _mm256_cmpeq_epi16(_mm256_or_si256(X, O), _mm256_set1_epi16(BOARD_CELLS));
+    for (int l = 0; l < 8; l++) {
+        __m256i line = _mm256_set1_epi16(winLines[l]);
+        __m256i xl = _mm256_and_si256(X, line), ol = _mm256_and_si256(O, line);
+        __m256i noX = _mm256_cmpeq_epi16(xl, zero), noO = _mm256_cmpeq_epi16(ol, zero);
+        wonX = _mm256_or_si256(wonX, _mm256_cmpeq_epi16(xl, line));
+        wonO = _mm256_or_si256(wonO, _mm256_cmpeq_epi16(ol, line));
+        openX = _mm256_sub_epi16(openX, noO);
+        openO = _mm256_sub_epi16(openO, noX);
+        __m256i twoX = zero, twoO = zero;
+        for (int p = 0; p < 3; p++) {
+            __m256i pair = _mm256_set1_epi16(linePairs.pairs[l][p]);
+            twoX = _mm256_or_si256(twoX, _mm256_cmpeq_epi16(xl, pair));
+            twoO = _mm256_or_si256(twoO, _mm256_cmpeq_epi16(ol, pair));
+        }
+        setupsX = _mm256_sub_epi16(setupsX, _mm256_and_si256(twoX, noO));
+        setupsO = _mm256_sub_epi16(setupsO, _mm256_and_si256(twoO, noX));
+    }
+    return Summarise(Split(wonX), Split(wonO), Split(full), Split(openX), Split(openO), Split(setupsX), Split(setupsO));
+}
+
+#endif
+
+static bool Supported(MicroboardsKernel kernel)
+{
+#ifdef MICROBOARDS_X86
+    __builtin_cpu_init();
+    if (kernel == MicroboardsKernel::AVX2) return __builtin_cpu_supports("avx2");
+    if (kernel == MicroboardsKernel::SSE2) return __builtin_cpu_supports("sse2");
+#endif
+    return kernel == MicroboardsKernel::Scalar;
+}
+
+static MicroboardsKernel Best()
+{
+    if (Supported(MicroboardsKernel::AVX2)) return MicroboardsKernel::AVX2;
+    if (Supported(MicroboardsKernel::SSE2)) return MicroboardsKernel::SSE2;
+    return MicroboardsKernel::Scalar;
+}
+
+static MicroboardsKernel selected = Best();
+
+MicroboardsSummary analyseMicroboards(const std::array<uint16_t, 9> &x, const std::array<uint16_t, 9> &o)
+{
+#ifdef MICROBOARDS_X86
+    if (selected != MicroboardsKernel::Scalar) {
+        // Padding lanes are empty boards, which nothing reads back
+        alignas(32) uint16_t xs[BOARD_LANES] = {}, os[BOARD_LANES] = {};
+        std::memcpy(xs, x.data(), sizeof(x));
+        std::memcpy(os, o.data(), sizeof(o));
+        return selected == MicroboardsKernel::AVX2 ? AnalyseAVX2(xs, os) : AnalyseSSE2(xs, os);
+    }
+#endif
+    return AnalyseScalar(x, o);
+}
+
+MicroboardsKernel microboardsKernel()
+{
+    return selected;
+}
+
+bool setMicroboardsKernel(MicroboardsKernel kernel)
+{
+    if (!Supported(kernel)) return false;
+    selected = kernel;
+    return true;
+}
+
+const char *microboardsKernelName(MicroboardsKernel kernel)
+{
+    switch (kernel) {
+        case MicroboardsKernel::AVX2: return "avx2";
+        case MicroboardsKernel::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
@@ -0,0 +1,28 @@
+// microboards.h
+
+#ifndef MICROBOARDS_H
+#define MICROBOARDS_H
+
+#include <array>
+#include <cstdint>
+
+// The status of all nine microboards of a position, given the cells of X and of O on each board
+struct MicroboardsSummary {
+    std::array<uint16_t, 2> won;                        // Boards with three in a row of X / O
+    uint16_t full;                                      // Boards without an empty cell
+    std::array<std::array<uint8_t, 9>, 2> openLines;    // Per board, lines without any of the opponent's discs
+    std::array<std::array<uint8_t, 9>, 2> setups;       // Per board, two in a rows with the third cell empty
+};
+
+enum class MicroboardsKernel { Scalar, SSE2, AVX2 };
+
+// Tests the eight lines of all nine boards side by side, one vector lane per board. The widest kernel the
+// processor supports is picked at startup.
+MicroboardsSummary analyseMicroboards(const std::array<uint16_t, 9> &x, const std::array<uint16_t, 9> &o);
+
+MicroboardsKernel microboardsKernel();
+// Forces a kernel, to compare them; returns false and changes nothing when the processor lacks it
+bool setMicroboardsKernel(MicroboardsKernel kernel);
+const char *microboardsKernelName(MicroboardsKernel kernel);
+
+#endif //MICROBOARDS_H
@@ -0,0 +1,32 @@
+// movelist.h
+
+#ifndef MOVELIST_H
+#define MOVELIST_H
+
+#include <array>
+
+#define MAX_MOVES 81
+
+// Fixed-capacity list of moves that lives on the stack, a UTTT position never has more than 81 moves
+template <class M, int N = MAX_MOVES>
+class MoveList {
+    std::array<M, N> moves;
+    int count = 0;
+
+public:
+    void push_back(const M &move) { moves[count++] = move; }
+    void clear() { count = 0; }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    M &operator[](int i) { return moves[i]; }
+    const M &operator[](int i) const { return moves[i]; }
+
+    M *begin() { return moves.data(); }
+    M *end() { return moves.data() + count; }
+    const M *begin() const { return moves.data(); }
+    const M *end() const { return moves.data() + count; }
+};
+
+#endif //MOVELIST_H
@@ -0,0 +1,223 @@
+// perft.cpp
+// Counts the positions reachable in exactly N moves from a set of stored positions and checks the counts
+// against reference values, which were produced with the original State implementation in uttt.cpp.
+//
+// perft [--position name] [--depth N] [--divide] [--threads N] [--legacy] [--verify] [--kernel scalar|sse2|avx2]
+//
+// --divide prints the count below every root move, --legacy runs the State implementation instead of
+// the bitboard, --verify recomputes everything makeMove keeps up to date at every node. Without
+// --threads the positions are counted both single threaded and split over all cores at the root. --kernel
+// picks the microboard kernel --verify cross-checks instead of the fastest one available.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bitboard.h"
+#include "microboards.h"
+#include "threadpool.h"
+#include "uttt.h"
+
+struct PerftPosition {
+    const char *name;
+    const char *moves;              // Moves from the empty board as "x y" pairs, separated by commas
+    std::vector<long> counts;       // Reference counts for depth 1, 2, ...
+};
+
+static const std::vector<PerftPosition> positions = {
+        {"start", "", {81, 720, 6336, 55080, 473256, 4020960, 33782544}},
+        {"midgame", "6 2,0 8,1 8,5 6,7 0,4 1,4 3,3 2,1 7,3 4,0 4,2 5,7 8,3 8,1 6,5 0", {7, 53, 845, 13143, 193628, 2798342, 38580457}},
+        {"free-choice", "5 4,8 3,6 2,0 6,1 0,5 2,7 6,5 1,6 3,1 1,3 3,0 0,0 2,1 8,4 6,4 0,3 0,2 2,7 8,3 6", {57, 552, 5246, 48436, 440446, 3969488, 35959574}},
+        {"endgame", "6 0,1 2,3 7,2 4,8 5,7 8,4 7,5 4,8 4,6 5,1 8,3 6,0 2,0 7,1 5,4 6,3 2,0 6,0 1,0 3,0 0,1 3,3 1,2 3,6 2,1 7,4 4,5 3,8 1,6 3,8 3,8 2,8 7,5 5,8 6,7 0,4 2,5 8,8 8,5 0", {4, 24, 224, 1572, 11939, 64594, 376101, 1522130, 6716323, 20244662}},
+};
+
+static const uint16_t lines[8] = {0x007, 0x038, 0x1C0, 0x049, 0x092, 0x124, 0x111, 0x054};
+
+static bool ParseMoves(const std::string &text, BitState &state)
+{
+    std::stringstream stream(text);
+    std::string move;
+    while (std::getline(stream, move, ',')) {
+        std::stringstream coordinates(move);
+        Move m{-1, -1};
+        coordinates >> m.x >> m.y;
+        std::vector<Move> legal = getMoves(state);
+        if (std::none_of(legal.begin(), legal.end(), [&](const Move &l) { return l.x == m.x && l.y == m.y; })) {
+            std::cout << "Illegal move " << move << std::endl;
+            return false;
+        }
+        state = doMove(state, m);
+    }
+    return true;
+}
+
+// Recomputes the state from its discs without any lookup tables and compares it with what makeMove maintained
+static bool Verify(const BitState &state)
+{
+    std::array<uint16_t, 2> won{};
+    std::array<uint8_t, 2> setups{};
+    uint16_t drawn = 0;
+    int pieces = 0, open = 0;
+    for (int b = 0; b < 9; b++) {
+        uint16_t x = state.cells[0][b], o = state.cells[1][b];
+        pieces += __builtin_popcount(x | o);
+        for (uint16_t line : lines) {
+            if ((x & line) == line) won[0] |= 1 << b;
+            if ((o & line) == line) won[1] |= 1 << b;
+        }
+        if ((won[0] | won[1]) & (1 << b)) continue;
+        if ((x | o) == BOARD_MASK) drawn |= 1 << b;
+        open += 9 - __builtin_popcount(x | o);
+        for (uint16_t line : lines) {
+            if (__builtin_popcount(x & line) == 2 && !(o & line)) setups[0]++;
+            if (__builtin_popcount(o & line) == 2 && !(x & line)) setups[1]++;
+        }
+    }
+
+    // The board kernel sees decided boards too, only its counts for undecided ones make up the state's
+    MicroboardsSummary summary = analyseMicroboards(state.cells[0], state.cells[1]);
+    std::array<uint8_t, 2> kernelSetups{};
+    for (int b = 0; b < 9; b++) {
+        if ((won[0] | won[1] | drawn) & (1 << b)) continue;
+        kernelSetups[0] += summary.setups[0][b];
+        kernelSetups[1] += summary.setups[1][b];
+    }
+
+    bool ok = true;
+    auto check = [&](bool same, const char *what) {
+        if (!same) std::cout << "Mismatch in " << what << std::endl;
+        ok = ok && same;
+    };
+    check(state.hash == computeHash(state), "hash");
+    check(state.won == won, "won boards");
+    check(state.drawn == drawn, "drawn boards");
+    check(state.setups == setups, "two in a rows");
+    check(state.pieces == pieces, "pieces");
+    check(state.open == open, "open cells");
+    check(summary.won == won && (summary.full & ~(won[0] | won[1])) == drawn && kernelSetups == setups, "board kernel");
+    return ok;
+}
+
+static long Perft(BitState &state, int depth, bool verify)
+{
+    if (verify && !Verify(state)) return 0;
+    if (depth == 0) return 1;
+
+    MoveList<int> moves;
+    getMoveIndices(state, moves);
+    if (depth == 1 && !verify) return moves.size();
+
+    long nodes = 0;
+    Undo undo;
+    for (int move : moves) {
+        makeMove(state, move, undo);
+        nodes += Perft(state, depth - 1, verify);
+        unmakeMove(state, move, undo);
+    }
+    return nodes;
+}
+
+static long LegacyPerft(const State &state, int depth)
+{
+    if (depth == 0) return 1;
+    std::vector<Move> moves = getMoves(state);
+    if (depth == 1) return moves.size();
+
+    long nodes = 0;
+    for (const Move &move : moves) nodes += LegacyPerft(doMove(state, move), depth - 1);
+    return nodes;
+}
+
+// Counts below every root move, the root moves are handed out one by one to the pool's threads
+static std::vector<long> Divide(const BitState &root, int depth, ThreadPool &pool, bool legacy, bool verify)
+{
+    std::vector<Move> moves = getMoves(root);
+    std::vector<long> counts(moves.size());
+    std::atomic<int> next(0);
+    WaitGroup group;
+
+    group.Add(pool.Size());
+    for (int t = 0; t < pool.Size(); t++) {
+        pool.Submit([&] {
+            for (int i = next++; i < (int) moves.size(); i = next++) {
+                BitState child = doMove(root, moves[i]);
+                counts[i] = legacy ? LegacyPerft(toState(child), depth - 1) : Perft(child, depth - 1, verify);
+            }
+            group.Done();
+        });
+    }
+    group.Wait();
+    return counts;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string only;
+    int depth = 0;
+    int threads = 0;
+    bool divide = false, legacy = false, verify = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--position" && i + 1 < argc) only = argv[++i];
+        else if (arg == "--depth" && i + 1 < argc) depth = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--divide") divide = true;
+        else if (arg == "--legacy") legacy = true;
+        else if (arg == "--verify") verify = true;
+        else if (arg == "--kernel" && i + 1 < argc) {
+            std::string name = argv[++i];
+            MicroboardsKernel kernel = name == "avx2" ? MicroboardsKernel::AVX2 : name == "sse2" ? MicroboardsKernel::SSE2 : MicroboardsKernel::Scalar;
+            if (name != microboardsKernelName(kernel) || !setMicroboardsKernel(kernel)) {
+                std::cout << "Board kernel not available: " << name << std::endl;
+                return 1;
+            }
+        }
+        else {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<int> threadCounts;
+    if (threads) threadCounts.push_back(threads);
+    else threadCounts = {1, std::max(1, (int) std::thread::hardware_concurrency())};
+    if (threadCounts.size() == 2 && threadCounts[1] == 1) threadCounts.pop_back();
+
+    bool allPassed = true;
+    for (const PerftPosition &position : positions) {
+        if (!only.empty() && only != position.name) continue;
+        BitState root;
+        if (!ParseMoves(position.moves, root)) return 1;
+        int positionDepth = depth ? depth : std::max(1, (int) position.counts.size());
+
+        for (int threadCount : threadCounts) {
+            ThreadPool pool(threadCount);
+            auto start = std::chrono::steady_clock::now();
+            std::vector<long> counts = Divide(root, positionDepth, pool, legacy, verify);
+            long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+            long total = 0;
+            for (long count : counts) total += count;
+            if (divide) {
+                std::vector<Move> moves = getMoves(root);
+                for (size_t i = 0; i < moves.size(); i++) std::cout << "  " << moves[i] << ": " << counts[i] << std::endl;
+            }
+
+            bool known = (size_t) positionDepth <= position.counts.size();
+            bool passed = !known || position.counts[positionDepth - 1] == total;
+            allPassed = allPassed && passed;
+            std::cout << std::left << std::setw(12) << position.name << std::right << " depth " << std::setw(2) << positionDepth
+                      << std::setw(12) << total << " nodes " << std::setw(8) << elapsed / 1000 << " ms "
+                      << std::setw(12) << (elapsed ? total * 1000000 / elapsed : 0) << " nodes/s  " << threadCount << " thread(s)  "
+                      << (!known ? "no reference" : passed ? "ok" : "MISMATCH, expected " + std::to_string(position.counts[positionDepth - 1])) << std::endl;
+        }
+    }
+
+    return allPassed ? 0 : 1;
+}
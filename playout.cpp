@@ -0,0 +1,172 @@
+// playout.cpp
+
+#include "playout.h"
+
+#define PLAYING -2      // Outcomes: the side that won, DRAW, or PLAYING while the game goes on
+#define DRAW -1
+
+struct PlayoutTables {
+    uint8_t nth[512][9];    // Cell of the n-th set bit of a 9-bit mask
+    bool wins[512];         // Whether a 3x3 mask holds a line, for microboards and the macroboard alike
+};
+
+static constexpr PlayoutTables BuildTables()
+{
+    constexpr uint16_t lines[8] = {0x007, 0x038, 0x1C0, 0x049, 0x092, 0x124, 0x111, 0x054};
+    PlayoutTables tables{};
+    for (int mask = 0; mask < 512; mask++) {
+        int n = 0;
+        for (int cell = 0; cell < 9; cell++)
+            if (mask & (1 << cell)) tables.nth[mask][n++] = cell;
+        for (uint16_t line : lines)
+            if ((mask & line) == line) tables.wins[mask] = true;
+    }
+    return tables;
+}
+
+static constexpr PlayoutTables tables = BuildTables();
+
+// One game in progress
+struct Lane {
+    uint16_t cells[2][9];
+    uint16_t won[2];
+    uint16_t decided;       // Boards won by either side or full
+    uint16_t active;
+    int side;
+    int position;           // Index of the start position, -1 once the lane has no games left
+    int moves;
+};
+
+static int Load(Lane &lane, const BitState &state, int position)
+{
+    for (int p = 0; p < 2; p++) {
+        for (int b = 0; b < 9; b++) lane.cells[p][b] = state.cells[p][b];
+        lane.won[p] = state.won[p];
+    }
+    lane.decided = state.won[0] | state.won[1] | state.drawn;
+    lane.active = state.active;
+    lane.side = state.side;
+    lane.position = position;
+    lane.moves = 0;
+
+    Player winner = getWinner(state);
+    if (winner != Player::None) return toSide(winner);
+    return state.active ? PLAYING : DRAW;
+}
+
+// Plays the move that the 32-bit random number picks among all legal moves
+static inline int Step(Lane &lane, uint32_t random)
+{
+    const uint16_t *x = lane.cells[0], *o = lane.cells[1];
+    uint16_t active = lane.active;
+    int board;
+    uint16_t empty;
+    uint32_t n;
+    if (!(active & (active - 1))) {
+        board = __builtin_ctz(active);
+        empty = ~(x[board] | o[board]) & BOARD_MASK;
+        n = (uint64_t(random) * __builtin_popcount(empty)) >> 32;
+    } else {
+        uint32_t total = 0;
+        for (uint16_t boards = active; boards; boards &= boards - 1) {
+            int b = __builtin_ctz(boards);
+            total += __builtin_popcount(~(x[b] | o[b]) & BOARD_MASK);
+        }
+        n = (uint64_t(random) * total) >> 32;
+        for (uint16_t boards = active;; boards &= boards - 1) {
+            board = __builtin_ctz(boards);
+            empty = ~(x[board] | o[board]) & BOARD_MASK;
+            uint32_t count = __builtin_popcount(empty);
+            if (n < count) break;
+            n -= count;
+        }
+    }
+
+    int cell = tables.nth[empty][n];
+    uint16_t &mine = lane.cells[lane.side][board];
+    mine |= 1 << cell;
+    lane.moves++;
+    if (tables.wins[mine]) {
+        lane.won[lane.side] |= 1 << board;
+        lane.decided |= 1 << board;
+        if (tables.wins[lane.won[lane.side]]) return lane.side;
+    } else if ((x[board] | o[board]) == BOARD_MASK) {
+        lane.decided |= 1 << board;
+    }
+
+    // The opponent is sent to the board matching the cell, or anywhere if that board is decided
+    uint16_t live = ~lane.decided & BOARD_MASK;
+    lane.active = live & (1 << cell) ? 1 << cell : live;
+    lane.side ^= 1;
+    return lane.active ? PLAYING : DRAW;
+}
+
+static void Record(PlayoutStats &stats, int outcome, int moves)
+{
+    stats.games++;
+    stats.moves += moves;
+    if (outcome == DRAW) stats.draws++;
+    else stats.wins[outcome]++;
+}
+
+void PlayoutStats::Add(const PlayoutStats &other)
+{
+    games += other.games;
+    wins[0] += other.wins[0];
+    wins[1] += other.wins[1];
+    draws += other.draws;
+    moves += other.moves;
+}
+
+void PlayoutKernel::Run(const BitState *positions, int count, long gamesEach, PlayoutStats *stats)
+{
+    for (int i = 0; i < count; i++) stats[i] = PlayoutStats();
+    const long games = count * gamesEach;
+    long next = 0;
+
+    // Gives a lane its next game, games that are over before they start are counted right away
+    auto start = [&](Lane &lane) {
+        while (next < games) {
+            int position = next++ / gamesEach;
+            int outcome = Load(lane, positions[position], position);
+            if (outcome == PLAYING) return true;
+            Record(stats[position], outcome, 0);
+        }
+        lane.position = -1;
+        return false;
+    };
+
+    Lane lanes[PLAYOUT_LANES];
+    int busy = 0;
+    for (Lane &lane : lanes) busy += start(lane);
+
+    while (busy) {
+        // One 64-bit number covers the moves of two lanes
+        for (int l = 0; l < PLAYOUT_LANES; l += 2) {
+            uint64_t bits = random.Next();
+            for (int half = 0; half < 2; half++) {
+                Lane &lane = lanes[l + half];
+                if (lane.position < 0) continue;
+                int outcome = Step(lane, static_cast<uint32_t>(half ? bits >> 32 : bits));
+                if (outcome == PLAYING) continue;
+                Record(stats[lane.position], outcome, lane.moves);
+                if (!start(lane)) busy--;
+            }
+        }
+    }
+}
+
+std::vector<PlayoutStats> PlayoutKernel::Run(const std::vector<BitState> &positions, long gamesEach)
+{
+    std::vector<PlayoutStats> stats(positions.size());
+    Run(positions.data(), positions.size(), gamesEach, stats.data());
+    return stats;
+}
+
+int PlayoutKernel::Play(const BitState &position)
+{
+    Lane lane;
+    int outcome = Load(lane, position, 0);
+    while (outcome == PLAYING) outcome = Step(lane, random.Next() >> 32);
+    return outcome;
+}
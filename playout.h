@@ -0,0 +1,45 @@
+// playout.h
+
+#ifndef PLAYOUT_H
+#define PLAYOUT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "bitboard.h"
+#include "fastrandom.h"
+
+#define PLAYOUT_LANES 8     // Games played side by side
+
+// Outcome of the random games played from one start position
+struct PlayoutStats {
+    long games = 0;
+    long wins[2] = {};      // Won by X / O
+    long draws = 0;
+    long moves = 0;         // Moves played in all games together
+
+    // Average result for the given side (0 = X), counting a win as 1 and a draw as 0.5
+    double Score(int side) const { return games ? (wins[side] + 0.5 * draws) / games : 0.5; }
+    void Add(const PlayoutStats &other);
+};
+
+// Plays uniformly random games to the end, many at a time. Every lane holds one game as bare bitmasks,
+// without the hash, counters and undo information of a BitState, and each step plays one move in every
+// lane. A lane whose game ends starts its next one at once, so the independent games fill each other's
+// stalls. A move is a random number below the count of empty cells on the active boards, resolved to a
+// cell with a table of the n-th set bit of every 9-bit mask: no move lists and nothing allocated.
+class PlayoutKernel {
+    CounterRandom random;
+
+public:
+    explicit PlayoutKernel(uint64_t seed = 1) : random(seed) {}
+
+    // Plays gamesEach games from every position, stats[i] receives the outcome of positions[i]
+    void Run(const BitState *positions, int count, long gamesEach, PlayoutStats *stats);
+    std::vector<PlayoutStats> Run(const std::vector<BitState> &positions, long gamesEach);
+
+    // One game from the position, for callers that need a single result: the winner's side, or -1 for a draw
+    int Play(const BitState &position);
+};
+
+#endif //PLAYOUT_H
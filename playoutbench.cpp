@@ -0,0 +1,154 @@
+// playoutbench.cpp
+// Measures how many random games per second each way of playing them manages, per core, and what the
+// games came to. All of them pick uniformly among the legal moves, so their outcomes only differ by chance.
+//
+// playoutbench [--ms N] [--positions N] [--plies N] [--threads N] [--seed S]
+//
+// legacy plays on State with getMoves, doMove and select_randomly, bitboard with makeMove, move lists and
+// FastRandom as MCTS used to, single runs PlayoutKernel::Play one game at a time and kernel runs the
+// lockstep batches of PlayoutKernel::Run. The games start from --positions positions reached by --plies
+// random moves from the empty board. With --threads every thread plays its own games.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bitboard.h"
+#include "fastrandom.h"
+#include "playout.h"
+#include "uttt.h"
+
+#define DEFAULT_BENCH_MILLISECONDS 2000
+#define DEFAULT_BENCH_POSITIONS 64
+#define BENCH_CHUNK 64      // Games per position between looks at the clock
+
+// Plays one round of games from every position into stats, using the given thread's state
+using Method = std::function<void(const std::vector<BitState> &, uint64_t, PlayoutStats &)>;
+
+static void Record(PlayoutStats &stats, Player winner, int moves)
+{
+    stats.games++;
+    stats.moves += moves;
+    if (winner == Player::None) stats.draws++;
+    else stats.wins[toSide(winner)]++;
+}
+
+static void PlayLegacy(const std::vector<BitState> &positions, uint64_t seed, PlayoutStats &stats)
+{
+    std::mt19937 random(seed);
+    for (const BitState &position : positions) {
+        for (int g = 0; g < BENCH_CHUNK; g++) {
+            State state = toState(position);
+            int moves = 0;
+            for (std::vector<Move> legal = getMoves(state); !legal.empty() && getWinner(state) == Player::None; legal = getMoves(state), moves++)
+                state = doMove(state, *select_randomly(legal.begin(), legal.end(), random));
+            Record(stats, getWinner(state), moves);
+        }
+    }
+}
+
+static void PlayBitboard(const std::vector<BitState> &positions, uint64_t seed, PlayoutStats &stats)
+{
+    FastRandom random(seed);
+    for (const BitState &position : positions) {
+        for (int g = 0; g < BENCH_CHUNK; g++) {
+            BitState state = position;
+            MoveList<int> moves;
+            Undo undo;
+            int played = 0;
+            for (getMoveIndices(state, moves); !moves.empty(); getMoveIndices(state, moves), played++)
+                makeMove(state, moves[random.Below(moves.size())], undo);
+            Record(stats, getWinner(state), played);
+        }
+    }
+}
+
+static void PlaySingle(const std::vector<BitState> &positions, uint64_t seed, PlayoutStats &stats)
+{
+    PlayoutKernel kernel(seed);
+    for (const BitState &position : positions) {
+        for (int g = 0; g < BENCH_CHUNK; g++) {
+            int outcome = kernel.Play(position);
+            stats.games++;
+            if (outcome < 0) stats.draws++;
+            else stats.wins[outcome]++;
+        }
+    }
+}
+
+static void PlayKernel(const std::vector<BitState> &positions, uint64_t seed, PlayoutStats &stats)
+{
+    PlayoutKernel kernel(seed);
+    for (const PlayoutStats &position : kernel.Run(positions, BENCH_CHUNK)) stats.Add(position);
+}
+
+int main(int argc, char *argv[])
+{
+    int milliseconds = DEFAULT_BENCH_MILLISECONDS;
+    size_t count = DEFAULT_BENCH_POSITIONS;
+    int plies = 0;
+    int threads = 1;
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--ms" && i + 1 < argc) milliseconds = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--positions" && i + 1 < argc) count = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--plies" && i + 1 < argc) plies = std::max(0, std::stoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc) seed = std::stoull(argv[++i]);
+        else {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // Start positions, openings that already ended are played on until they have not
+    std::vector<BitState> positions;
+    FastRandom random(seed);
+    while (positions.size() < count) {
+        BitState position;
+        MoveList<int> moves;
+        Undo undo;
+        for (int ply = 0; ply < plies && (getMoveIndices(position, moves), !moves.empty()); ply++)
+            makeMove(position, moves[random.Below(moves.size())], undo);
+        if (getMoveIndices(position, moves), !moves.empty()) positions.push_back(position);
+    }
+
+    const std::vector<std::pair<const char *, Method>> methods = {
+            {"legacy", PlayLegacy}, {"bitboard", PlayBitboard}, {"single", PlaySingle}, {"kernel", PlayKernel}};
+    std::cout << "Random games from " << count << " position(s) after " << plies << " plies, " << milliseconds << " ms per method, "
+              << threads << " thread(s)." << std::endl;
+    for (const auto &method : methods) {
+        std::vector<PlayoutStats> totals(threads);
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                for (uint64_t round = 0; !stop; round++) method.second(positions, seed + round * threads + t, totals[t]);
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+        stop = true;
+        for (std::thread &worker : workers) worker.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        PlayoutStats total;
+        for (const PlayoutStats &stats : totals) total.Add(stats);
+        double perSecond = total.games / seconds;
+        std::cout << std::left << std::setw(10) << method.first << std::right << std::setw(12) << total.games << " games "
+                  << std::setw(12) << (long) perSecond << " /s " << std::setw(12) << (long) (perSecond / threads) << " /s per core  "
+                  << std::fixed << std::setprecision(1) << "X " << 100.0 * total.wins[0] / total.games << "%  O " << 100.0 * total.wins[1] / total.games
+                  << "%  draw " << 100.0 * total.draws / total.games << "%";
+        if (total.moves) std::cout << "  " << double(total.moves) / total.games << " moves/game";
+        std::cout << std::defaultfloat << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,207 @@
+// proofsearch.cpp
+
+#include "proofsearch.h"
+
+#include <algorithm>
+
+#include "tablebase.h"
+
+#define PROOF_BUCKET 4
+#define PROOF_CHECK_NODES 1024                      // Positions between looks at the clock, a power of two
+#define PROOF_ATTACKER_KEY 0x9E3779B97F4A7C15ULL    // Keeps the numbers of both attackers apart in the table
+
+ProofSearch::ProofSearch(int megabytes)
+{
+    size_t buckets = 1;
+    while (buckets * 2 * PROOF_BUCKET * sizeof(Entry) <= (size_t) megabytes << 20) buckets *= 2;
+    entries.reset(new Entry[buckets * PROOF_BUCKET]());
+    mask = buckets - 1;
+}
+
+uint64_t ProofSearch::Key(const BitState &state) const
+{
+    return attacker ? state.hash ^ PROOF_ATTACKER_KEY : state.hash;
+}
+
+const ProofSearch::Entry *ProofSearch::Find(uint64_t key) const
+{
+    const Entry *bucket = &entries[(key & mask) * PROOF_BUCKET];
+    for (int i = 0; i < PROOF_BUCKET; i++)
+        if (bucket[i].key == key) return &bucket[i];
+    return nullptr;
+}
+
+void ProofSearch::Store(uint64_t key, uint32_t pn, uint32_t dn, uint32_t work)
+{
+    Entry *bucket = &entries[(key & mask) * PROOF_BUCKET];
+    Entry *slot = &bucket[0];
+    for (int i = 0; i < PROOF_BUCKET; i++) {
+        if (bucket[i].key == key) {
+            slot = &bucket[i];
+            break;
+        }
+        if (bucket[i].work < slot->work) slot = &bucket[i];
+    }
+    *slot = Entry{key, pn, dn, work};
+}
+
+// Positions whose outcome is known without searching: the game is over, or the tablebase has them
+bool ProofSearch::Settled(const BitState &state, uint32_t &pn, uint32_t &dn) const
+{
+    bool attackerWins;
+    EndgameValue value;
+    Player winner = getWinner(state);
+    if (winner != Player::None) attackerWins = winner == toPlayer(attacker);
+    else if (!state.active) attackerWins = false;
+    else if (state.open <= Tablebase::Get().MaxEmpty() && Tablebase::Get().Probe(state, value))
+        attackerWins = value.outcome != Outcome::Draw && (value.outcome == Outcome::Win) == (state.side == attacker);
+    else return false;
+
+    pn = attackerWins ? 0 : PROOF_INFINITY;
+    dn = attackerWins ? PROOF_INFINITY : 0;
+    return true;
+}
+
+// Numbers of a position about to be chosen from: settled, from the table, or else guessed from its number of
+// moves, since the side to move is only stopped once every one of them is refuted
+void ProofSearch::Numbers(BitState &state, uint32_t &pn, uint32_t &dn) const
+{
+    if (Settled(state, pn, dn)) return;
+    if (const Entry *entry = Find(Key(state))) {
+        pn = entry->pn;
+        dn = entry->dn;
+        return;
+    }
+    MoveList<int> moves;
+    getMoveIndices(state, moves);
+    pn = state.side == attacker ? 1 : moves.size();
+    dn = state.side == attacker ? moves.size() : 1;
+}
+
+static uint32_t Sum(const uint32_t *numbers, int count)
+{
+    uint64_t sum = 0;
+    for (int i = 0; i < count; i++) {
+        if (numbers[i] == PROOF_INFINITY) return PROOF_INFINITY;
+        sum += numbers[i];
+    }
+    return std::min<uint64_t>(sum, PROOF_INFINITY - 1);
+}
+
+// Index of the smallest number, and the second smallest
+static int Smallest(const uint32_t *numbers, int count, uint32_t &second)
+{
+    int best = 0;
+    second = PROOF_INFINITY;
+    for (int i = 1; i < count; i++) {
+        if (numbers[i] < numbers[best]) {
+            second = numbers[best];
+            best = i;
+        } else if (numbers[i] < second) {
+            second = numbers[i];
+        }
+    }
+    return best;
+}
+
+static uint32_t Clamp(uint64_t number)
+{
+    return std::min<uint64_t>(number, PROOF_INFINITY);
+}
+
+// Searches the position, which is not settled, until its proof number reaches thresholdPn or its disproof
+// number reaches thresholdDn. The attacker's positions are OR nodes, one winning move proves them; the
+// defender's are AND nodes, where every move has to be answered.
+void ProofSearch::Search(BitState &state, uint32_t thresholdPn, uint32_t thresholdDn, uint32_t &pn, uint32_t &dn)
+{
+    if ((++nodes & (PROOF_CHECK_NODES - 1)) == 0 && ((nodeLimit && nodes >= nodeLimit) || std::chrono::steady_clock::now() >= deadline))
+        stopped = true;
+    long before = nodes;
+
+    MoveList<int> moves;
+    getMoveIndices(state, moves);
+    uint32_t childPn[81], childDn[81];
+    Undo undo;
+    for (int i = 0; i < moves.size(); i++) {
+        makeMove(state, moves[i], undo);
+        Numbers(state, childPn[i], childDn[i]);
+        unmakeMove(state, moves[i], undo);
+    }
+
+    const bool orNode = state.side == attacker;
+    int best;
+    while (true) {
+        uint32_t second;
+        if (orNode) {
+            best = Smallest(childPn, moves.size(), second);
+            pn = childPn[best];
+            dn = Sum(childDn, moves.size());
+        } else {
+            best = Smallest(childDn, moves.size(), second);
+            pn = Sum(childPn, moves.size());
+            dn = childDn[best];
+        }
+        if (pn >= thresholdPn || dn >= thresholdDn || stopped) break;
+
+        // The chosen child gets until its number passes that of the runner-up, or the parent's threshold
+        uint32_t nextPn = orNode ? std::min(thresholdPn, Clamp(uint64_t(second) + 1)) : Clamp(uint64_t(thresholdPn) - pn + childPn[best]);
+        uint32_t nextDn = orNode ? Clamp(uint64_t(thresholdDn) - dn + childDn[best]) : std::min(thresholdDn, Clamp(uint64_t(second) + 1));
+        makeMove(state, moves[best], undo);
+        Search(state, nextPn, nextDn, childPn[best], childDn[best]);
+        unmakeMove(state, moves[best], undo);
+    }
+
+    Store(Key(state), pn, dn, std::min<long>(nodes - before + 1, UINT32_MAX));
+    if (shared && pn == 0)
+        shared->Store(state.hash, orNode ? winScore : -winScore, TT_DEPTH_SOLVED, Bound::Exact, orNode ? moves[best] : TT_NO_MOVE);
+}
+
+ProofResult ProofSearch::Solve(const BitState &state, int side, std::chrono::steady_clock::time_point until, long limit)
+{
+    attacker = side;
+    deadline = until;
+    nodeLimit = limit;
+    nodes = 0;
+    stopped = false;
+    line.clear();
+
+    BitState root = state;
+    uint32_t pn, dn;
+    if (!Settled(root, pn, dn)) Search(root, PROOF_INFINITY, PROOF_INFINITY, pn, dn);
+    if (pn == 0) {
+        BuildLine(root);
+        return ProofResult::Proven;
+    }
+    return dn == 0 ? ProofResult::Disproven : ProofResult::Unknown;
+}
+
+// Follows proven positions down the table. The attacker takes the win that needed the least work to prove,
+// the defender the reply that needed the most, which is usually the one that holds out longest.
+void ProofSearch::BuildLine(BitState state)
+{
+    uint32_t pn, dn;
+    while (!Settled(state, pn, dn)) {
+        MoveList<int> moves;
+        getMoveIndices(state, moves);
+        int chosen = -1;
+        uint32_t chosenWork = 0;
+        Undo undo;
+        for (int move : moves) {
+            makeMove(state, move, undo);
+            uint32_t work = 0;
+            bool proven = Settled(state, pn, dn) && pn == 0;
+            if (const Entry *entry = proven ? nullptr : Find(Key(state))) {
+                proven = entry->pn == 0;
+                work = entry->work;
+            }
+            unmakeMove(state, move, undo);
+            if (proven && (chosen < 0 || (state.side == attacker ? work < chosenWork : work > chosenWork))) {
+                chosen = move;
+                chosenWork = work;
+            }
+        }
+        if (chosen < 0) break;      // Pushed out of the table
+        line.push_back(toMove(chosen));
+        makeMove(state, chosen, undo);
+    }
+}
@@ -0,0 +1,67 @@
+// proofsearch.h
+
+#ifndef PROOFSEARCH_H
+#define PROOFSEARCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "bitboard.h"
+#include "transposition.h"
+
+#define DEFAULT_PROOF_MEGABYTES 16
+#define PROOF_INFINITY 0x3FFFFFFFu      // Proof or disproof number of a settled position
+
+enum class ProofResult { Unknown, Proven, Disproven };
+
+// Depth-first proof-number search (df-pn). Proves that the attacker wins a position by force, or that it
+// cannot because the defender wins or the game ends in a draw. Forcing sequences in UTTT keep sending the
+// opponent to the same few boards, so they run deep but narrow: df-pn follows them long before a full-width
+// search of that depth would. Proof and disproof numbers live in a table of four-entry buckets that is kept
+// between searches; within a bucket the entry with the least work below it is replaced first.
+class ProofSearch {
+    struct Entry {
+        uint64_t key;       // 0 for an empty slot
+        uint32_t pn, dn;
+        uint32_t work;      // Positions searched below this one, saturating
+    };
+
+    std::unique_ptr<Entry[]> entries;
+    size_t mask = 0;                            // Bucket count - 1
+    int attacker = 0;
+    std::chrono::steady_clock::time_point deadline;
+    long nodeLimit = 0;
+    long nodes = 0;
+    bool stopped = false;
+    TranspositionTable *shared = nullptr;
+    int winScore = 0;
+    std::vector<Move> line;
+
+    uint64_t Key(const BitState &state) const;
+    const Entry *Find(uint64_t key) const;
+    void Store(uint64_t key, uint32_t pn, uint32_t dn, uint32_t work);
+    bool Settled(const BitState &state, uint32_t &pn, uint32_t &dn) const;
+    void Numbers(BitState &state, uint32_t &pn, uint32_t &dn) const;
+    void Search(BitState &state, uint32_t thresholdPn, uint32_t thresholdDn, uint32_t &pn, uint32_t &dn);
+    void BuildLine(BitState state);
+
+public:
+    explicit ProofSearch(int megabytes = DEFAULT_PROOF_MEGABYTES);
+
+    // Settled positions are also stored in this table, as +-winScore solved to the end for the side to move,
+    // so the main search finds them without searching them again
+    void ShareWith(TranspositionTable *table, int score) { shared = table; winScore = score; }
+
+    // Searches whether the given side (0 = X) wins by force, until the answer is found, the deadline passes,
+    // or nodeLimit (0 = none) positions were searched
+    ProofResult Solve(const BitState &state, int side, std::chrono::steady_clock::time_point until, long limit = 0);
+    long LastNodes() const { return nodes; }
+    // After a proof, the moves from the searched position to the end of the game as far as the table still
+    // holds them: the attacker's winning moves and the replies that hold out longest
+    const std::vector<Move> &LastLine() const { return line; }
+};
+
+#endif //PROOFSEARCH_H
@@ -0,0 +1,28 @@
+// protocol.cpp
+
+#include "protocol.h"
+
+#include <charconv>
+
+std::string_view nextToken(std::string_view &rest, char delim) {
+	size_t end = rest.find(delim);
+	std::string_view token = rest.substr(0, end);
+	rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+	return token;
+}
+
+int toInt(std::string_view text) {
+	int value = 0;
+	std::from_chars(text.data(), text.data() + text.size(), value);
+	return value;
+}
+
+Player toCell(std::string_view field) {
+	if (field == "0") return Player::X;
+	if (field == "1") return Player::O;
+	return Player::None;
+}
+
+Player toMacroCell(std::string_view field) {
+	return field == "-1" ? Player::Active : toCell(field);
+}
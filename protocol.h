@@ -0,0 +1,21 @@
+// protocol.h
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <string_view>
+
+#include "uttt.h"
+
+// Pieces of the text protocol shared by the bot and the batch analysis. They work on views into the line
+// that was read, so nothing is copied.
+
+// Splits the next token off the front of rest
+std::string_view nextToken(std::string_view &rest, char delim);
+int toInt(std::string_view text);
+// A field value: "0" and "1" are the players' discs, anything else is an empty cell
+Player toCell(std::string_view field);
+// A macroboard value, where "-1" marks the boards that may be played in
+Player toMacroCell(std::string_view field);
+
+#endif //PROTOCOL_H
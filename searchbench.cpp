@@ -0,0 +1,111 @@
+// searchbench.cpp
+// Measures the alpha-beta search on random positions and, with --verify, checks it against plain minimax.
+//
+// searchbench [--depth N] [--positions N] [--plies N] [--seed S] [--verify]
+//
+// Every position is searched to --depth from an empty transposition table, once collecting the statistics the
+// engine reports and once without them. Both have to return the same rating after the same number of nodes.
+// --verify also runs TreeSearch without pruning, a plain minimax, whose ratings the pruned search has to match.
+// The positions are reached by --plies random moves from the empty board.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bitboard.h"
+#include "fastrandom.h"
+#include "TreeSearch.h"
+#include "utttai.h"
+
+#define DEFAULT_BENCH_DEPTH 6
+#define DEFAULT_BENCH_POSITIONS 20
+#define DEFAULT_BENCH_PLIES 20
+#define BENCH_HASH_MEGABYTES 16
+
+struct SearchRun {
+    int rating = 0;
+    long nodes = 0;
+    long microseconds = 0;
+};
+
+template <bool Pruning, bool CollectStats>
+static SearchRun Search(const BitState &position, int depth)
+{
+    TranspositionTable table(BENCH_HASH_MEGABYTES);
+    MoveOrdering<int> ordering;
+    TreeSearch<UTTTAI::SearchPolicy, Pruning, CollectStats> search(&table, &ordering);
+    BitState root = position;
+    bool fullTree = true;
+
+    SearchRun run;
+    auto start = std::chrono::steady_clock::now();
+    run.rating = search.NegaMax(root, depth, -WIN_SCORE, +WIN_SCORE, &fullTree);
+    run.microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    run.nodes = search.Nodes();
+    return run;
+}
+
+int main(int argc, char *argv[])
+{
+    int depth = DEFAULT_BENCH_DEPTH;
+    size_t count = DEFAULT_BENCH_POSITIONS;
+    int plies = DEFAULT_BENCH_PLIES;
+    uint64_t seed = 1;
+    bool verify = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--depth" && i + 1 < argc) depth = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--positions" && i + 1 < argc) count = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--plies" && i + 1 < argc) plies = std::max(0, std::stoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc) seed = std::stoull(argv[++i]);
+        else if (arg == "--verify") verify = true;
+        else {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // Start positions, openings that already ended are played on until they have not
+    std::vector<BitState> positions;
+    FastRandom random(seed);
+    while (positions.size() < count) {
+        BitState position;
+        MoveList<int> moves;
+        Undo undo;
+        for (int ply = 0; ply < plies && (getMoveIndices(position, moves), !moves.empty()); ply++)
+            makeMove(position, moves[random.Below(moves.size())], undo);
+        if (getMoveIndices(position, moves), !moves.empty()) positions.push_back(position);
+    }
+
+    const char *names[] = {"stats", "no stats", "minimax"};
+    SearchRun totals[3];
+    int mismatches = 0;
+    for (size_t p = 0; p < positions.size(); p++) {
+        SearchRun runs[3] = {Search<true, true>(positions[p], depth), Search<true, false>(positions[p], depth)};
+        if (verify) runs[2] = Search<false, false>(positions[p], depth);
+        for (int m = 0; m < (verify ? 3 : 2); m++) {
+            totals[m].nodes += runs[m].nodes;
+            totals[m].microseconds += runs[m].microseconds;
+        }
+
+        bool same = runs[1].rating == runs[0].rating && runs[1].nodes == runs[0].nodes && (!verify || runs[2].rating == runs[0].rating);
+        if (!same) {
+            mismatches++;
+            std::cout << "MISMATCH at position " << p << ": rating " << runs[0].rating << " after " << runs[0].nodes << " nodes, without stats "
+                      << runs[1].rating << " after " << runs[1].nodes << (verify ? ", minimax " + std::to_string(runs[2].rating) : "") << std::endl;
+        }
+    }
+
+    std::cout << positions.size() << " position(s) after " << plies << " plies, depth " << depth << "." << std::endl;
+    for (int m = 0; m < (verify ? 3 : 2); m++) {
+        const SearchRun &total = totals[m];
+        std::cout << std::left << std::setw(10) << names[m] << std::right << std::setw(12) << total.nodes << " nodes " << std::setw(8)
+                  << total.microseconds / 1000 << " ms " << std::setw(12) << (total.microseconds ? total.nodes * 1000000 / total.microseconds : 0)
+                  << " nodes/s" << std::endl;
+    }
+    std::cout << (mismatches ? std::to_string(mismatches) + " mismatch(es)" : "All ratings agree") << "." << std::endl;
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+// searchstats.cpp
+
+#include "searchstats.h"
+
+#include <algorithm>
+#include <sstream>
+
+void SearchCounters::Add(const SearchCounters &other)
+{
+    nodes += other.nodes;
+    leaves += other.leaves;
+    cutoffs += other.cutoffs;
+    for (int i = 0; i < CUTOFF_SLOTS; i++) cutoffsAt[i] += other.cutoffsAt[i];
+    ttProbes += other.ttProbes;
+    ttHits += other.ttHits;
+    ttCutoffs += other.ttCutoffs;
+    tbHits += other.tbHits;
+    maxPly = std::max(maxPly, other.maxPly);
+}
+
+double SearchStats::BranchingFactor() const
+{
+    const IterationStats *last = nullptr, *previous = nullptr;
+    for (const IterationStats &iteration : iterations) {
+        if (!iteration.completed) continue;
+        previous = last;
+        last = &iteration;
+    }
+    return last && previous && previous->nodes ? double(last->nodes) / previous->nodes : 0.0;
+}
+
+static double Ratio(long part, long whole)
+{
+    return whole ? double(part) / whole : 0.0;
+}
+
+// One line, no spaces outside strings, so it can be picked out of a log with grep
+std::string SearchStats::ToJson() const
+{
+    std::ostringstream json;
+    json << "{\"engine\":\"" << engine << "\""
+         << ",\"move\":[" << move.x << "," << move.y << "]"
+         << ",\"score\":" << score
+         << ",\"pieces\":" << pieces
+         << ",\"threads\":" << threads
+         << ",\"budgetMs\":" << budgetMilliseconds
+         << ",\"ms\":" << milliseconds
+         << ",\"depth\":" << depth
+         << ",\"selDepth\":" << counters.maxPly
+         << ",\"nodes\":" << nodes
+         << ",\"nps\":" << (milliseconds ? nodes * 1000 / milliseconds : 0)
+         << ",\"leaves\":" << counters.leaves
+         << ",\"cutoffs\":" << counters.cutoffs
+         << ",\"cutoffsAt\":[";
+    for (int i = 0; i < CUTOFF_SLOTS; i++) json << (i ? "," : "") << counters.cutoffsAt[i];
+    json << "],\"firstMoveCutoffRate\":" << Ratio(counters.cutoffsAt[0], counters.cutoffs)
+         << ",\"ttProbes\":" << counters.ttProbes
+         << ",\"ttHitRate\":" << Ratio(counters.ttHits, counters.ttProbes)
+         << ",\"ttCutoffRate\":" << Ratio(counters.ttCutoffs, counters.ttProbes)
+         << ",\"tbHits\":" << counters.tbHits
+         << ",\"ebf\":" << BranchingFactor()
+         << ",\"treeNodes\":" << treeNodes
+         << ",\"winRate\":" << winRate
+         << ",\"exhausted\":" << (exhausted ? "true" : "false")
+         << ",\"ponderHit\":" << (ponderHit ? "true" : "false")
+         << ",\"proof\":\"" << proof << "\""
+         << ",\"proofNodes\":" << proofNodes
+         << ",\"proofLine\":[";
+    for (size_t i = 0; i < proofLine.size(); i++) json << (i ? "," : "") << "[" << proofLine[i].x << "," << proofLine[i].y << "]";
+    json << "]"
+         << ",\"allocations\":" << allocations
+         << ",\"iterations\":[";
+    for (size_t i = 0; i < iterations.size(); i++) {
+        const IterationStats &iteration = iterations[i];
+        json << (i ? "," : "") << "{\"depth\":" << iteration.depth << ",\"nodes\":" << iteration.nodes << ",\"ms\":" << iteration.milliseconds
+             << ",\"rated\":" << iteration.movesRated << ",\"completed\":" << (iteration.completed ? "true" : "false") << "}";
+    }
+    json << "]}";
+    return json.str();
+}
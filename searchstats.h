@@ -0,0 +1,64 @@
+// searchstats.h
+
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+
+#include <string>
+#include <vector>
+
+#include "uttt.h"
+
+#define CUTOFF_SLOTS 4      // Cutoffs are counted by the index of the move causing them: 1st, 2nd, 3rd, later
+
+// Counted by each search thread on the hot path, plain increments only
+struct SearchCounters {
+    long nodes = 0;                 // Positions entered
+    long leaves = 0;                // Positions evaluated, at the horizon or at the end of the game
+    long cutoffs = 0;
+    long cutoffsAt[CUTOFF_SLOTS] = {};
+    long ttProbes = 0;
+    long ttHits = 0;                // Probes that found the position
+    long ttCutoffs = 0;             // Hits that answered the position without searching it
+    long tbHits = 0;                // Positions answered by the endgame tablebase
+    int maxPly = 0;                 // Deepest position entered, counted from the root
+
+    void Add(const SearchCounters &other);
+};
+
+// One pass of iterative deepening
+struct IterationStats {
+    int depth = 0;
+    long nodes = 0;
+    long milliseconds = 0;          // Since the search of this turn started
+    int movesRated = 0;
+    bool completed = false;
+};
+
+// Everything one turn of the AI did, returned together with the chosen move
+struct SearchStats {
+    std::string engine;
+    Move move{-1, -1};
+    int score = 0;                  // Rating of the move for the side playing it, +-WIN_SCORE once the game is decided
+    int pieces = 0;                 // Discs on the board before the move
+    int threads = 0;
+    long budgetMilliseconds = 0;
+    long milliseconds = 0;
+    int depth = 0;                  // Deepest completed pass, or deepest tree node for MCTS
+    long nodes = 0;                 // Nodes searched, or playouts for MCTS
+    long treeNodes = 0;             // MCTS only: nodes kept in the tree
+    double winRate = 0;             // MCTS only, instead of the score: share of the move's playouts won, draws count half
+    bool exhausted = false;         // The outcome of the game is known
+    bool ponderHit = false;
+    std::string proof;              // "win" or "loss" when the proof-number solver settled the position
+    std::vector<Move> proofLine;    // The forced line it proved, from this position
+    long proofNodes = 0;            // Positions the solver searched
+    long allocations = -1;          // Heap allocations during the search, -1 when not counted
+    SearchCounters counters;
+    std::vector<IterationStats> iterations;
+
+    // Nodes of the last completed pass divided by those of the pass before, 0 without two passes
+    double BranchingFactor() const;
+    std::string ToJson() const;
+};
+
+#endif //SEARCHSTATS_H
@@ -0,0 +1,106 @@
+// server.cpp
+
+#include "server.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "log.h"
+#include "protocol.h"
+
+#define SERVER_MIN_SEARCH_MILLISECONDS 5    // Search time of a request whose deadline already passed
+
+UTTTServer::UTTTServer(const ServerOptions &options) : options(options)
+{
+    for (int w = 0; w < std::max(1, options.workers); w++) workers.emplace_back(&UTTTServer::Work, this);
+}
+
+UTTTServer::~UTTTServer()
+{
+    {
+        std::lock_guard<std::mutex> lock(requestsMutex);
+        stopping = true;
+    }
+    requested.notify_all();
+    for (std::thread &worker : workers) worker.join();
+}
+
+void UTTTServer::run()
+{
+    std::string line;
+    while (std::getline(std::cin, line)) input(line);
+}
+
+void UTTTServer::input(std::string_view line)
+{
+    std::string_view rest = line;
+    std::string id(nextToken(rest, ' '));
+    std::string_view command = nextToken(rest, ' ');
+    std::string_view first = nextToken(rest, ' ');
+    std::string_view second = nextToken(rest, ' ');
+
+    std::lock_guard<std::mutex> lock(gamesMutex);
+    if (command == "settings") {
+        games[id].setting(first, second);
+    } else if (command == "update" && first == "game") {
+        games[id].update(second, nextToken(rest, ' '));
+    } else if (command == "action" && first == "move") {
+        // The deadline is set by the time left for this game, not by when a worker gets to it
+        GameSession &session = games[id];
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(UTTTAI::TimeBudget(toInt(second), session.time_per_move));
+        {
+            std::lock_guard<std::mutex> requestsLock(requestsMutex);
+            requests.push(MoveRequest{deadline, id, session});
+        }
+        requested.notify_one();
+    } else if (command == "end") {
+        games.erase(id);
+    } else {
+        LOG_WARN("Unknown command: " << line);
+    }
+}
+
+void UTTTServer::Work()
+{
+    AIOptions engine = options.engine;
+    engine.threads = 1;
+    engine.ponder = false;
+    UTTTAI ai(engine);
+
+    while (true) {
+        MoveRequest request;
+        {
+            std::unique_lock<std::mutex> lock(requestsMutex);
+            requested.wait(lock, [&] { return stopping || !requests.empty(); });
+            if (requests.empty()) return;
+            request = requests.top();
+            requests.pop();
+        }
+
+        // Search for whatever is left until the deadline, SAFETY_MARGIN comes off again in the budget. A request
+        // picked up late still gets long enough for a first pass or a few playouts rather than none.
+        long left = std::chrono::duration_cast<std::chrono::milliseconds>(request.deadline - std::chrono::steady_clock::now()).count();
+        int timeout = static_cast<int>(std::max<long>(SERVER_MIN_SEARCH_MILLISECONDS, left)) + SAFETY_MARGIN;
+        request.session.time_per_move = timeout;
+        SearchStats stats;
+        Move m = UTTTBot::decide(request.session, ai, timeout, stats);
+
+        std::vector<Move> legal = getMoves(request.session.state);
+        if (!legal.empty() && std::none_of(legal.begin(), legal.end(), [&](const Move &move) { return move.x == m.x && move.y == m.y; })) {
+            LOG_ERROR("ERROR: " << request.game << " search returned illegal move " << m << ", playing " << legal[0] << " instead.");
+            m = legal[0];
+        }
+
+        // Recorded before the move goes out, or the opponent's reply could be compared with the field from before it
+        {
+            std::lock_guard<std::mutex> lock(gamesMutex);
+            auto game = games.find(request.game);
+            if (game != games.end()) game->second.played(m);
+        }
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << request.game << " place_disc " << m << std::endl;
+        }
+        if (options.engine.statsJson) LOG_INFO(request.game << " " << stats.ToJson());
+    }
+}
@@ -0,0 +1,66 @@
+// server.h
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "utttai.h"
+#include "utttbot.h"
+
+struct ServerOptions {
+    AIOptions engine;           // Settings of every worker's engine, each searches with one thread
+    int workers = 1;
+};
+
+// Hosts many games in one process. Every input line is a game id followed by a protocol command, and every
+// move goes out prefixed with the id of its game:
+//
+//   g7 settings your_bot player0
+//   g7 action move 10000          ->   g7 place_disc 4 4
+//   g7 end                        forgets the game
+//
+// Games are only protocol state. Their moves are searched by a fixed set of workers, each owning a single
+// threaded engine, taking the request with the earliest deadline first. Tables, the opening book and the
+// tablebase exist once for the whole process.
+class UTTTServer {
+    struct MoveRequest {
+        std::chrono::steady_clock::time_point deadline;
+        std::string game;
+        GameSession session;        // Copy at the time of the request
+    };
+    struct LaterDeadline {
+        bool operator()(const MoveRequest &a, const MoveRequest &b) const { return a.deadline > b.deadline; }
+    };
+
+    ServerOptions options;
+    std::unordered_map<std::string, GameSession> games;
+    std::mutex gamesMutex;
+    std::priority_queue<MoveRequest, std::vector<MoveRequest>, LaterDeadline> requests;
+    std::mutex requestsMutex;
+    std::condition_variable requested;
+    bool stopping = false;
+    std::mutex outputMutex;
+    std::vector<std::thread> workers;
+
+    void Work();
+
+public:
+    explicit UTTTServer(const ServerOptions &options);
+    // Answers the moves still waiting, then stops the workers
+    ~UTTTServer();
+
+    // Reads stdin until it ends
+    void run();
+    void input(std::string_view line);
+};
+
+#endif //SERVER_H
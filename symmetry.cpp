@@ -0,0 +1,141 @@
+// symmetry.cpp
+
+#include "symmetry.h"
+
+#include <algorithm>
+
+// Maps (x, y) on an n by n grid, n - 1 = last
+static constexpr void Apply(int symmetry, int last, int x, int y, int &tx, int &ty)
+{
+    switch (symmetry) {
+        case 0: tx = x;        ty = y;        break;
+        case 1: tx = last - y; ty = x;        break;    // Rotate 90 degrees
+        case 2: tx = last - x; ty = last - y; break;    // Rotate 180 degrees
+        case 3: tx = y;        ty = last - x; break;    // Rotate 270 degrees
+        case 4: tx = last - x; ty = y;        break;    // Mirror left-right
+        case 5: tx = x;        ty = last - y; break;    // Mirror top-bottom
+        case 6: tx = y;        ty = x;        break;    // Mirror in the main diagonal
+        default: tx = last - y; ty = last - x; break;   // Mirror in the anti-diagonal
+    }
+}
+
+static constexpr Symmetry::Tables BuildTables()
+{
+    Symmetry::Tables tables{};
+    for (int s = 0; s < SYMMETRIES; s++) {
+        for (int y = 0; y < 9; y++) {
+            for (int x = 0; x < 9; x++) {
+                int tx = 0, ty = 0;
+                Apply(s, 8, x, y, tx, ty);
+                int from = (y / 3 * 3 + x / 3) * 9 + y % 3 * 3 + x % 3;
+                int to = (ty / 3 * 3 + tx / 3) * 9 + ty % 3 * 3 + tx % 3;
+                tables.squares[s][from] = to;
+                tables.images[from][s] = to;
+            }
+        }
+        for (int mask = 0; mask < 512; mask++) {
+            for (int cell = 0; cell < 9; cell++) {
+                if (!(mask & (1 << cell))) continue;
+                int tx = 0, ty = 0;
+                Apply(s, 2, cell % 3, cell / 3, tx, ty);
+                tables.masks[s][mask] |= 1 << (ty * 3 + tx);
+            }
+        }
+    }
+    return tables;
+}
+
+constexpr Symmetry::Tables Symmetry::tables = BuildTables();
+
+BitState Symmetry::Transform(const BitState &state, int symmetry)
+{
+    BitState result = state;
+    for (int p = 0; p < 2; p++) {
+        for (int b = 0; b < 9; b++) {
+            int board = tables.squares[symmetry][b * 9 + 4] / 9;   // Where the centre of b ends up
+            result.cells[p][board] = Mask(symmetry, state.cells[p][b]);
+        }
+        result.won[p] = Mask(symmetry, state.won[p]);
+    }
+    result.drawn = Mask(symmetry, state.drawn);
+    result.active = Mask(symmetry, state.active);
+    result.hash = computeHash(result);
+    return result;
+}
+
+uint64_t Symmetry::Hash(const BitState &state, int symmetry)
+{
+    const uint8_t *squares = tables.squares[symmetry];
+    uint64_t hash = Zobrist::keys.active[Mask(symmetry, state.active)];
+    if (state.side) hash ^= Zobrist::keys.side;
+    for (int p = 0; p < 2; p++)
+        for (int b = 0; b < 9; b++)
+            for (uint16_t cells = state.cells[p][b]; cells; cells &= cells - 1)
+                hash ^= Zobrist::keys.cells[p][squares[b * 9 + __builtin_ctz(cells)]];
+    return hash;
+}
+
+void Symmetry::Hashes(const BitState &state, uint64_t (&hashes)[SYMMETRIES])
+{
+    uint64_t side = state.side ? Zobrist::keys.side : 0;
+    for (int s = 0; s < SYMMETRIES; s++) hashes[s] = Zobrist::keys.active[Mask(s, state.active)] ^ side;
+    for (int p = 0; p < 2; p++) {
+        const uint64_t *keys = Zobrist::keys.cells[p];
+        for (int b = 0; b < 9; b++) {
+            for (uint16_t cells = state.cells[p][b]; cells; cells &= cells - 1) {
+                const uint8_t *images = tables.images[b * 9 + __builtin_ctz(cells)];
+                for (int s = 0; s < SYMMETRIES; s++) hashes[s] ^= keys[images[s]];
+            }
+        }
+    }
+}
+
+uint64_t Symmetry::CanonicalHash(const BitState &state)
+{
+    uint64_t hash;
+    CanonicalSymmetry(state, hash);
+    return hash;
+}
+
+int Symmetry::CanonicalSymmetry(const BitState &state, uint64_t &hash)
+{
+    uint64_t hashes[SYMMETRIES];
+    Hashes(state, hashes);
+    int canonical = 0;
+    for (int s = 1; s < SYMMETRIES; s++)
+        if (hashes[s] < hashes[canonical]) canonical = s;
+    hash = hashes[canonical];
+    return canonical;
+}
+
+uint8_t Symmetry::Stabiliser(const BitState &state)
+{
+    uint8_t stabiliser = 1;
+    for (int s = 1; s < SYMMETRIES; s++) {
+        bool same = Mask(s, state.active) == state.active && Mask(s, state.drawn) == state.drawn;
+        for (int p = 0; p < 2 && same; p++) {
+            same = Mask(s, state.won[p]) == state.won[p];
+            for (int b = 0; b < 9 && same; b++)
+                same = Mask(s, state.cells[p][b]) == state.cells[p][tables.squares[s][b * 9 + 4] / 9];
+        }
+        if (same) stabiliser |= 1 << s;
+    }
+    return stabiliser;
+}
+
+std::vector<Move> Symmetry::DistinctMoves(const BitState &state)
+{
+    std::vector<Move> moves = getMoves(state);
+    uint8_t stabiliser = Stabiliser(state);
+    if (stabiliser == 1) return moves;
+
+    // Keeps the move with the lowest square index of every group of equivalent ones
+    auto equivalentToLower = [stabiliser](const Move &move) {
+        int index = toIndex(move);
+        for (int s = 1; s < SYMMETRIES; s++)
+            if ((stabiliser & (1 << s)) && tables.squares[s][index] < index) return true;
+        return false;
+    };
+    moves.erase(std::remove_if(moves.begin(), moves.end(), equivalentToLower), moves.end());
+    return moves;
+}
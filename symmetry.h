@@ -0,0 +1,46 @@
+// symmetry.h
+
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <cstdint>
+#include <vector>
+#include "bitboard.h"
+
+#define SYMMETRIES 8
+
+// The eight symmetries of the square. Applied to the 9x9 grid they move microboards and the cells
+// inside them the same way, so a transformed position is just as legal and has the same value.
+// Symmetry 0 is the identity.
+class Symmetry {
+public:
+    struct Tables {
+        uint8_t squares[SYMMETRIES][81];        // Square index -> transformed square index
+        uint8_t images[81][SYMMETRIES];         // The same, one row of all eight images per square
+        uint16_t masks[SYMMETRIES][512];        // 3x3 mask (cells of a board, or boards) -> transformed mask
+    };
+    static const Tables tables;
+
+    static int Square(int symmetry, int index) { return tables.squares[symmetry][index]; }
+    static uint16_t Mask(int symmetry, uint16_t mask) { return tables.masks[symmetry][mask]; }
+    // The symmetry that undoes the given one, only the quarter turns are not their own inverse
+    static int Inverse(int symmetry) { return symmetry == 1 ? 3 : symmetry == 3 ? 1 : symmetry; }
+
+    static BitState Transform(const BitState &state, int symmetry);
+    // Hash of the transformed position, without building it
+    static uint64_t Hash(const BitState &state, int symmetry);
+    // Hashes of all eight transformed positions in a single walk over the discs
+    static void Hashes(const BitState &state, uint64_t (&hashes)[SYMMETRIES]);
+    // Smallest hash over all symmetries, the same for every position in a symmetry class
+    static uint64_t CanonicalHash(const BitState &state);
+    // The symmetry that yields the canonical hash, and that hash
+    static int CanonicalSymmetry(const BitState &state, uint64_t &hash);
+
+    // Bit s is set when symmetry s maps the position onto itself, bit 0 always is
+    static uint8_t Stabiliser(const BitState &state);
+    // The legal moves minus those that the position's own symmetries map onto an earlier one, which lead
+    // to positions of the same value. Only positions early in the game or mirrored by hand lose any.
+    static std::vector<Move> DistinctMoves(const BitState &state);
+};
+
+#endif //SYMMETRY_H
@@ -0,0 +1,77 @@
+// tablebase.cpp
+
+#include "tablebase.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "log.h"
+#include "symmetry.h"
+
+#define KEY_MASK (~0xFFFFULL)
+
+Tablebase &Tablebase::Get()
+{
+    static Tablebase tablebase;
+    return tablebase;
+}
+
+bool Tablebase::Open(const std::string &path)
+{
+    Close();
+    if (!file.Open(path, sizeof(Header))) {
+        LOG_ERROR("ERROR: Could not open tablebase " << path << ".");
+        return false;
+    }
+
+    const Header *header = static_cast<const Header *>(file.Data());
+    if (header->magic != TABLEBASE_MAGIC || header->version != TABLEBASE_VERSION || sizeof(Header) + header->count * sizeof(uint64_t) != file.Size()) {
+        LOG_ERROR("ERROR: " << path << " is not a valid tablebase.");
+        file.Close();
+        return false;
+    }
+
+    entries = reinterpret_cast<const uint64_t *>(header + 1);
+    count = header->count;
+    maxEmpty = header->maxEmpty;
+    LOG_INFO("Loaded tablebase " << path << " with " << count << " positions of up to " << maxEmpty << " open cells.");
+    return true;
+}
+
+void Tablebase::Close()
+{
+    file.Close();
+    entries = nullptr;
+    count = 0;
+    maxEmpty = -1;
+}
+
+bool Tablebase::Probe(const BitState &state, EndgameValue &value) const
+{
+    if (state.open > maxEmpty || !count) return false;
+    uint64_t key = Symmetry::CanonicalHash(state) & KEY_MASK;
+    const uint64_t *entry = std::lower_bound(entries, entries + count, key);
+    if (entry == entries + count || (*entry & KEY_MASK) != key) return false;
+    value.outcome = static_cast<Outcome>((*entry >> 8) & 0xFF);
+    value.distance = *entry & 0xFF;
+    return true;
+}
+
+uint64_t Tablebase::Pack(uint64_t key, const EndgameValue &value)
+{
+    return (key & KEY_MASK) | static_cast<uint64_t>(value.outcome) << 8 | value.distance;
+}
+
+bool Tablebase::Write(const std::string &path, int maxEmpty, std::vector<uint64_t> &entries)
+{
+    // Two positions sharing 48 bits of hash keep only the first of their entries
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end(), [](uint64_t a, uint64_t b) { return (a & KEY_MASK) == (b & KEY_MASK); }), entries.end());
+
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    Header header{TABLEBASE_MAGIC, TABLEBASE_VERSION, static_cast<uint32_t>(maxEmpty), entries.size()};
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1
+                   && std::fwrite(entries.data(), sizeof(uint64_t), entries.size(), file) == entries.size();
+    return std::fclose(file) == 0 && written;
+}
@@ -0,0 +1,51 @@
+// tablebase.h
+
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bitboard.h"
+#include "endgame.h"
+#include "mappedfile.h"
+
+#define TABLEBASE_MAGIC 0x3142545454545455ULL     // "UTTTTTB1"
+#define TABLEBASE_VERSION 1
+
+// Solved endgames on disk. The file is a header followed by a sorted array of 64-bit entries: the top 48 bits
+// of the canonical hash of a position, its Outcome and its distance. The file is memory-mapped, so opening
+// it costs nothing and the pages are shared between processes. One table serves the whole process.
+class Tablebase {
+    struct Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t maxEmpty;
+        uint64_t count;
+    };
+
+    MappedFile file;
+    const uint64_t *entries = nullptr;
+    size_t count = 0;
+    int maxEmpty = -1;
+
+    Tablebase() = default;
+
+public:
+    static Tablebase &Get();
+
+    bool Open(const std::string &path);
+    void Close();
+    size_t Size() const { return count; }
+    int MaxEmpty() const { return maxEmpty; }      // -1 while no table is open
+
+    bool Probe(const BitState &state, EndgameValue &value) const;
+
+    static uint64_t Pack(uint64_t key, const EndgameValue &value);
+    // Sorts the entries and writes them, returns whether that worked
+    static bool Write(const std::string &path, int maxEmpty, std::vector<uint64_t> &entries);
+};
+
+#endif //TABLEBASE_H
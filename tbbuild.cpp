@@ -0,0 +1,81 @@
+// tbbuild.cpp
+// Builds an endgame tablebase. Random games are played until at most the given number of cells is open,
+// each of those positions is solved exactly, and every position the solver met on the way is stored.
+//
+// tbbuild [--empty N] [--games N] [--threads N] [--seed S] [--out file]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bitboard.h"
+#include "endgame.h"
+#include "fastrandom.h"
+#include "tablebase.h"
+
+#define DEFAULT_TABLEBASE_GAMES 1000
+#define DEFAULT_TABLEBASE_FILE "endgame.tb"
+
+int main(int argc, char *argv[])
+{
+    int maxEmpty = DEFAULT_ENDGAME_EMPTY;
+    int games = DEFAULT_TABLEBASE_GAMES;
+    int threads = std::max(1, (int) std::thread::hardware_concurrency());
+    uint64_t seed = 1;
+    std::string out = DEFAULT_TABLEBASE_FILE;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--empty" && i + 1 < argc) maxEmpty = std::max(1, std::min(81, std::stoi(argv[++i])));
+        else if (arg == "--games" && i + 1 < argc) games = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc) seed = std::stoull(argv[++i]);
+        else if (arg == "--out" && i + 1 < argc) out = argv[++i];
+        else {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint64_t> entries;
+    std::mutex mutex;
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            EndgameSolver solver;
+            for (int game = next++; game < games; game = next++) {
+                FastRandom random(seed + game);
+                BitState position;
+                MoveList<int> moves;
+                Undo undo;
+                for (getMoveIndices(position, moves); !moves.empty() && position.open > maxEmpty; getMoveIndices(position, moves))
+                    makeMove(position, moves[random.Below(moves.size())], undo);
+                if (!moves.empty()) solver.Solve(position);
+
+                if ((game + 1) % 100 == 0) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    std::cout << "Game " << game + 1 << ", this thread solved " << solver.Solved().size() << " positions." << std::endl;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto &position : solver.Solved()) entries.push_back(Tablebase::Pack(position.first, position.second));
+        });
+    }
+    for (std::thread &worker : workers) worker.join();
+
+    if (!Tablebase::Write(out, maxEmpty, entries)) {
+        std::cout << "Could not write " << out << "." << std::endl;
+        return 1;
+    }
+    long elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Wrote " << entries.size() << " positions (" << entries.size() * sizeof(uint64_t) / 1024 << " kB) to " << out
+              << " in " << elapsed << " s." << std::endl;
+    return 0;
+}
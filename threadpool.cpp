@@ -0,0 +1,68 @@
+// threadpool.cpp
+
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(int threads)
+{
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(&ThreadPool::Work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (std::thread &worker : workers) worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    available.notify_one();
+}
+
+void ThreadPool::Work()
+{
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void WaitGroup::Add(int count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pending += count;
+}
+
+void WaitGroup::Done()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--pending == 0) finished.notify_all();
+}
+
+void WaitGroup::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return pending == 0; });
+}
+
+// Returns false if the jobs were still running at the deadline
+bool WaitGroup::WaitUntil(std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return finished.wait_until(lock, deadline, [this] { return pending == 0; });
+}
@@ -0,0 +1,46 @@
+// threadpool.h
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run submitted jobs in FIFO order. Meant to be created once
+// and kept for the lifetime of the process.
+class ThreadPool {
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable available;
+    bool stopping = false;
+
+    void Work();
+
+public:
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    int Size() const { return static_cast<int>(workers.size()); }
+    void Submit(std::function<void()> job);
+};
+
+// Lets one thread wait for a number of jobs running elsewhere to finish
+class WaitGroup {
+    int pending = 0;
+    std::mutex mutex;
+    std::condition_variable finished;
+
+public:
+    void Add(int count);
+    void Done();
+    void Wait();
+    bool WaitUntil(std::chrono::steady_clock::time_point deadline);
+};
+
+#endif //THREADPOOL_H
@@ -0,0 +1,91 @@
+// transposition.cpp
+
+#include "transposition.h"
+
+// data layout: value (16 bits) | depth (8) | bound (8) | move (8) | generation (8)
+static uint64_t Pack(int value, int depth, Bound bound, int move, uint8_t generation)
+{
+    return static_cast<uint16_t>(value)
+           | static_cast<uint64_t>(depth) << 16
+           | static_cast<uint64_t>(bound) << 24
+           | static_cast<uint64_t>(move) << 32
+           | static_cast<uint64_t>(generation) << 40;
+}
+
+static int DepthOf(uint64_t data) { return (data >> 16) & 0xFF; }
+static int MoveOf(uint64_t data) { return (data >> 32) & 0xFF; }
+static uint8_t GenerationOf(uint64_t data) { return (data >> 40) & 0xFF; }
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+{
+    Resize(megabytes);
+}
+
+// Uses the largest power of two number of buckets that fits in the memory budget
+void TranspositionTable::Resize(size_t megabytes)
+{
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) count *= 2;
+    buckets.reset(new Bucket[count]);
+    mask = count - 1;
+    Clear();
+}
+
+void TranspositionTable::Clear()
+{
+    for (uint64_t i = 0; i <= mask; i++) {
+        for (Slot &slot : buckets[i].slots) {
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Entries from earlier searches are kept for lookups but are the first to be replaced
+void TranspositionTable::NewSearch()
+{
+    generation++;
+}
+
+bool TranspositionTable::Probe(uint64_t key, TTEntry &entry) const
+{
+    const Bucket &bucket = buckets[key & mask];
+    for (const Slot &slot : bucket.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if (!data || (slot.check.load(std::memory_order_relaxed) ^ data) != key) continue;
+        entry.value = static_cast<int16_t>(data & 0xFFFF);
+        entry.depth = DepthOf(data);
+        entry.bound = static_cast<Bound>((data >> 24) & 0xFF);
+        entry.move = MoveOf(data);
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::Store(uint64_t key, int value, int depth, Bound bound, int move)
+{
+    Bucket &bucket = buckets[key & mask];
+    Slot *victim = nullptr;
+    int victimWorth = 0;
+
+    for (Slot &slot : bucket.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if (data && (slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+            // Same position: keep a deeper result from this search unless the new one is exact
+            if (depth < DepthOf(data) && GenerationOf(data) == generation && bound != Bound::Exact) return;
+            if (move == TT_NO_MOVE) move = MoveOf(data);
+            victim = &slot;
+            break;
+        }
+
+        int worth = !data ? -1 : DepthOf(data) + (GenerationOf(data) == generation ? 256 : 0);
+        if (!victim || worth < victimWorth) {
+            victim = &slot;
+            victimWorth = worth;
+        }
+    }
+
+    uint64_t data = Pack(value, depth, bound, move, generation);
+    victim->data.store(data, std::memory_order_relaxed);
+    victim->check.store(key ^ data, std::memory_order_relaxed);
+}
@@ -0,0 +1,51 @@
+// transposition.h
+
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <cstdint>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#define TT_DEPTH_SOLVED 255     // Subtree was searched to the end of the game, valid at any depth
+#define TT_NO_MOVE 255
+
+enum class Bound : uint8_t { None, Exact, Lower, Upper };
+
+struct TTEntry {
+    int value;      // From the perspective of the side to move
+    int depth;
+    Bound bound;
+    int move;
+};
+
+// Fixed-size hash table of search results, four entries per 64 byte bucket (one cache line).
+// Within a bucket the shallowest entry, or one left over from an earlier search, is replaced first.
+// Search threads share one table without locking: both words of a slot are written with relaxed
+// atomics and a slot only matches when they belong together, so a torn write is simply a miss.
+class TranspositionTable {
+    struct Slot {
+        std::atomic<uint64_t> check;    // key ^ data
+        std::atomic<uint64_t> data;
+    };
+    struct alignas(64) Bucket {
+        Slot slots[4];
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    uint64_t mask = 0;
+    uint8_t generation = 0;
+
+public:
+    explicit TranspositionTable(size_t megabytes);
+
+    void Resize(size_t megabytes);
+    void Clear();
+    void NewSearch();
+
+    bool Probe(uint64_t key, TTEntry &entry) const;
+    void Store(uint64_t key, int value, int depth, Bound bound, int move);
+};
+
+#endif //TRANSPOSITION_H
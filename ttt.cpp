@@ -3,96 +3,102 @@
 
 #include "ttt.h"
 
-// Returns the winner (if any) of a given microboard
-Player ttt::GetWinner(const MicroState &b)
+static constexpr uint16_t winLines[8] = {
+        0x007, 0x038, 0x1C0,    // Horizontal
+        0x049, 0x092, 0x124,    // Vertical
+        0x111, 0x054            // Diagonal
+};
+
+static constexpr int CountBits(uint16_t mask)
+{
+    int count = 0;
+    for (; mask; mask &= mask - 1) count++;
+    return count;
+}
+
+// Analyses a single microboard, given the cells occupied by X and by O
+static constexpr ttt::Info Analyse(uint16_t x, uint16_t o)
 {
-    // Horizontal
-    if(b[0] == b[1] && b[1] == b[2] && b[2] != Player::None) return b[0];
-    if(b[3] == b[4] && b[4] == b[5] && b[5] != Player::None) return b[3];
-    if(b[6] == b[7] && b[7] == b[8] && b[8] != Player::None) return b[6];
+    ttt::Info info{};
+    Player winner = Player::None;
 
-    // Vertical
-    if(b[0] == b[3] && b[3] == b[6] && b[6] != Player::None) return b[0];
-    if(b[1] == b[4] && b[4] == b[7] && b[7] != Player::None) return b[1];
-    if(b[2] == b[5] && b[5] == b[8] && b[8] != Player::None) return b[2];
+    for (uint16_t line : winLines) {
+        if (winner == Player::None && (x & line) == line) winner = Player::X;
+        else if (winner == Player::None && (o & line) == line) winner = Player::O;
 
-    // Diagonal
-    if(b[0] == b[4] && b[4] == b[8] && b[8] != Player::None) return b[0];
-    if(b[2] == b[4] && b[4] == b[6] && b[6] != Player::None) return b[2];
+        // Two in a row with the third cell still empty
+        if (CountBits(x & line) == 2 && !(o & line)) info.setups[0]++;
+        if (CountBits(o & line) == 2 && !(x & line)) info.setups[1]++;
 
-    return  Player::None;
+        // A line without any of the opponent's discs can still be won
+        if (!(o & line)) info.openLines[0]++;
+        if (!(x & line)) info.openLines[1]++;
+    }
+
+    info.winner = static_cast<uint8_t>(winner);
+    if (winner == Player::None) {
+        info.moves = ~(x | o) & 0x1FF;
+        bool xCanWin = info.openLines[0] > 0, oCanWin = info.openLines[1] > 0;
+        info.winnableBy = static_cast<uint8_t>(xCanWin && oCanWin ? Player::Both : xCanWin ? Player::X : oCanWin ? Player::O : Player::None);
+    } else {
+        info.winnableBy = static_cast<uint8_t>(Player::None);
+    }
+    return info;
 }
 
-// Checks if the given players has at least 1 occurrence of two in a row in the given microboard
-int ttt::CheckSetups(const MicroState &b, const Player &player)
+static constexpr ttt::Tables BuildTables()
 {
-    int count = 0;
+    ttt::Tables tables{};
+    for (int mask = 0; mask < 512; mask++) {
+        int code = 0;
+        for (int cell = 8; cell >= 0; cell--) code = code * 3 + ((mask >> cell) & 1);
+        tables.base3[mask] = code;
+    }
+    for (int code = 0; code < 19683; code++) {
+        uint16_t x = 0, o = 0;
+        for (int cell = 0, rest = code; cell < 9; cell++, rest /= 3) {
+            if (rest % 3 == 1) x |= 1 << cell;
+            else if (rest % 3 == 2) o |= 1 << cell;
+        }
+        tables.info[code] = Analyse(x, o);
+    }
+    return tables;
+}
 
-    // Horizontal
-    if(b[0] == b[1] && b[2] == Player::None && b[0] == player) count++;
-    if(b[3] == b[4] && b[5] == Player::None && b[3] == player) count++;
-    if(b[6] == b[7] && b[7] == Player::None && b[6] == player) count++;
-    if(b[0] == b[2] && b[1] == Player::None && b[0] == player) count++;
-    if(b[3] == b[5] && b[4] == Player::None && b[3] == player) count++;
-    if(b[6] == b[8] && b[7] == Player::None && b[6] == player) count++;
-    if(b[1] == b[2] && b[0] == Player::None && b[1] == player) count++;
-    if(b[4] == b[5] && b[3] == Player::None && b[4] == player) count++;
-    if(b[7] == b[8] && b[6] == Player::None && b[7] == player) count++;
+constexpr ttt::Tables ttt::tables = BuildTables();
 
-    // Vertical
-    if(b[0] == b[3] && b[6] == Player::None && b[0] == player) count++;
-    if(b[1] == b[4] && b[7] == Player::None && b[1] == player) count++;
-    if(b[2] == b[5] && b[8] == Player::None && b[2] == player) count++;
-    if(b[0] == b[6] && b[3] == Player::None && b[0] == player) count++;
-    if(b[1] == b[7] && b[4] == Player::None && b[1] == player) count++;
-    if(b[2] == b[8] && b[5] == Player::None && b[2] == player) count++;
-    if(b[3] == b[6] && b[0] == Player::None && b[3] == player) count++;
-    if(b[4] == b[7] && b[1] == Player::None && b[4] == player) count++;
-    if(b[5] == b[8] && b[2] == Player::None && b[5] == player) count++;
+// Returns the base-3 code of a given microboard, used to index the lookup tables
+int ttt::Code(const MicroState &b)
+{
+    int code = 0;
+    for (int cell = 8; cell >= 0; cell--)
+        code = code * 3 + (b[cell] == Player::X ? 1 : b[cell] == Player::O ? 2 : 0);
+    return code;
+}
 
-    // Diagonal
-    if(b[0] == b[4] && b[8] == Player::None && b[0] == player) count++;
-    if(b[2] == b[4] && b[6] == Player::None && b[2] == player) count++;
-    if(b[4] == b[8] && b[0] == Player::None && b[4] == player) count++;
-    if(b[4] == b[6] && b[2] == Player::None && b[4] == player) count++;
-    if(b[8] == b[0] && b[4] == Player::None && b[8] == player) count++;
-    if(b[6] == b[2] && b[4] == Player::None && b[6] == player) count++;
+// Returns the winner (if any) of a given microboard
+Player ttt::GetWinner(const MicroState &b)
+{
+    return static_cast<Player>(tables.info[Code(b)].winner);
+}
 
-    return count;
+// Counts the occurrences of two in a row (with the third cell empty) of the given player in the given microboard
+int ttt::CheckSetups(const MicroState &b, const Player &player)
+{
+    return tables.info[Code(b)].setups[player == Player::X ? 0 : 1];
 }
 
 // Returns possible moves for a given microboard
 std::vector<int> ttt::GetMoves(const MicroState &b)
 {
     std::vector<int> moves = {};
-    if(GetWinner(b) != Player::None) return moves;
-    else for(int m = 0; m < 9; m++)
-        if(b[m] == Player::None) moves.push_back(m);
+    for (uint16_t empty = tables.info[Code(b)].moves; empty; empty &= empty - 1)
+        moves.push_back(__builtin_ctz(empty));
     return moves;
 }
 
 // Returns what players would be able to still win the given microboard
 Player ttt::IsWinnableBy(const MicroState &b)
 {
-    if(GetWinner(b) != Player::None) return Player::None;
-
-    Player winnableBy = Player::None;
-    int wins[8][3] = {
-            {0, 1, 2}, {3, 4, 5}, {6, 7, 8},
-            {0, 3, 6}, {1, 4, 7}, {2, 5, 8},
-            {0, 4, 8}, {2, 4, 6}
-    };
-
-    // Check if each win pos can still be occupied by each player
-    for(int w = 0; w < 8; w++)
-    {
-        if(b[wins[w][0]] != Player::X && b[wins[w][1]] != Player::X && b[wins[w][2]] != Player::X) // If player O can win this win
-            if(winnableBy == Player::X) return Player::Both;
-            else winnableBy = Player::O;
-
-        if(b[wins[w][0]] != Player::O && b[wins[w][1]] != Player::O && b[wins[w][2]] != Player::O) // If player O can win this win
-            if(winnableBy == Player::O) return Player::Both;
-            else winnableBy = Player::X;
-    }
-    return winnableBy;
+    return static_cast<Player>(tables.info[Code(b)].winnableBy);
 }
@@ -4,10 +4,30 @@
 #ifndef TTT_H
 #define TTT_H
 
+#include <cstdint>
 #include "uttt.h"
 
 class ttt {
 public:
+    // Everything the AI wants to know about one microboard, precomputed for all 3^9 boards
+    struct Info {
+        uint16_t moves;         // Mask of playable cells, empty once the board has a winner
+        uint8_t winner;         // Player
+        uint8_t winnableBy;     // Player
+        uint8_t setups[2];      // Two in a rows with an empty third cell, for X and O
+        uint8_t openLines[2];   // Lines without any of the opponent's discs, for X and O
+    };
+
+    struct Tables {
+        uint16_t base3[512];    // Cell mask -> sum of 3^cell
+        Info info[19683];       // Indexed by base-3 code: 0 = empty, 1 = X, 2 = O
+    };
+    static const Tables tables;
+
+    static int Code(uint16_t x, uint16_t o) { return tables.base3[x] + 2 * tables.base3[o]; }
+    static int Code(const MicroState & b);
+    static const Info & Lookup(uint16_t x, uint16_t o) { return tables.info[Code(x, o)]; }
+
     static std::vector<int> GetMoves(const MicroState & b);
     static Player GetWinner(const MicroState & b);
     static int CheckSetups(const MicroState &b, const Player &player);
@@ -2,6 +2,7 @@
 // Jeffrey Drost
 
 #include "uttt.h"
+#include "ttt.h"
 
 std::ostream &operator<<(std::ostream& os, const Player &p) {
 	if (p == Player::None) {
@@ -53,29 +54,14 @@ Player getCurrentPlayer(const State &state)
 
 Player getWinner(const State &state, int row, int col)
 {
-	for (int r=0; r<3; r++)
-		if (state.board[row*3+r][col*3] == state.board[row*3+r][col*3+1] && 
-				state.board[row*3+r][col*3+1] == state.board[row*3+r][col*3+2] && 
-				state.board[row*3+r][col*3+2] != Player::None) 
-			return state.board[row*3+r][col*3];
-	for (int c=0; c<3; c++)
-		if (state.board[row*3][col*3+c] == state.board[row*3+1][col*3+c] && 
-				state.board[row*3+1][col*3+c] == state.board[row*3+2][col*3+c] && 
-				state.board[row*3][col*3+c] != Player::None) 
-			return state.board[row*3][col*3+c];
-	if (state.board[row*3][col*3] == state.board[row*3+1][col*3+1] && 
-			state.board[row*3+1][col*3+1] == state.board[row*3+2][col*3+2] && 
-			state.board[row*3][col*3] != Player::None) 
-		return state.board[row*3][col*3];
-	if (state.board[row*3][col*3+2] == state.board[row*3+1][col*3+1] && 
-			state.board[row*3+1][col*3+1] == state.board[row*3+2][col*3] && 
-			state.board[row*3][col*3+2] != Player::None) 
-		return state.board[row*3][col*3+2];
+	MicroState b;
 	for (int r=0; r<3; r++)
 		for (int c=0; c<3; c++)
-			if (state.board[row*3+r][col*3+c] == Player::None)
-				return Player::Active;
-	return Player::None;
+			b[r*3+c] = state.board[row*3+r][col*3+c];
+	const ttt::Info &info = ttt::tables.info[ttt::Code(b)];
+	if (info.winner != static_cast<uint8_t>(Player::None))
+		return static_cast<Player>(info.winner);
+	return info.moves ? Player::Active : Player::None;
 }
 
 State doMove(const State &state, const Move &m)
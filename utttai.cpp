@@ -2,63 +2,357 @@
 // Jeffrey Drost
 
 #include "utttai.h"
-#include "TreeSearch.h"
+#include "alloccounter.h"
+#include "log.h"
+#include "symmetry.h"
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+
+UTTTAI::UTTTAI(const AIOptions &options) : options(options), table(options.hashMegabytes), pool(options.threads), orderings(options.threads),
+        random(options.seed ? options.seed : std::random_device()())
+{
+    if (options.engine == Engine::MCTS) mcts.reset(new MCTS(options.mctsMegabytes, options.seed ? options.seed : random()));
+    else if (options.proofShare > 0) {
+        proof.reset(new ProofSearch(options.proofMegabytes));
+        proof->ShareWith(&table, WIN_SCORE);
+    }
+}
+
+UTTTAI::~UTTTAI()
+{
+    StopPondering();
+}
+
+// Rates every root move at the given depth. The moves are handed out one by one in the given order to the worker threads,
+// which share the transposition table; each rating is written to the index of its move so the outcome
+// does not depend on which thread finished first. The threads stop themselves at the deadline or once they have
+// used up their share of the node limit, or when someone else raises the stop flag, after which only the moves
+// marked done have a rating. Returns whether all moves were rated.
+bool UTTTAI::SearchPass(const BitState &root, const std::vector<Move> &moves, const std::vector<int> &order, int depth, std::chrono::steady_clock::time_point deadline, long nodeLimit, std::atomic<bool> &stop, std::vector<int> &ratings, std::vector<char> &done, std::vector<char> &exhausted, SearchCounters &counters)
+{
+    std::atomic<int> next(0);
+    std::mutex mutex;
+    WaitGroup group;
+
+    group.Add(pool.Size());
+    for (int t = 0; t < pool.Size(); t++) {
+        pool.Submit([&, t] {
+            TreeSearch<SearchPolicy> search(&table, &orderings[t], &stop);
+            search.SetDeadline(deadline);
+            search.SetNodeLimit(nodeLimit ? std::max(1L, nodeLimit / pool.Size()) : 0);
+            for (int n = next++; n < (int) order.size() && !search.Stopped(); n = next++) {
+                int i = order[n];
+                bool fullMoveTreeEvaluated = true;
+                BitState child = doMove(root, moves[i]);
+                int rating = -search.NegaMax(child, depth, -WIN_SCORE, +WIN_SCORE, &fullMoveTreeEvaluated);
+                if (search.Stopped()) break;
+                ratings[i] = rating;
+                exhausted[i] = fullMoveTreeEvaluated;
+                done[i] = true;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                SearchCounters searched = search.Counters();
+                searched.maxPly++;  // The search started below the root
+                counters.Add(searched);
+            }
+            group.Done();
+        });
+    }
+
+    group.Wait();
+    return !stop;
+}
+
+// Time to spend on this move: the time per move, or twice that while the timebank is large,
+// always leaving a safety margin in the timebank
+int UTTTAI::TimeBudget(int timeout, int timePerMove)
+{
+    int budget = timeout > 5 * timePerMove ? 2 * timePerMove : timePerMove;
+    return std::max(1, std::min(budget, timeout) - SAFETY_MARGIN);
+}
+
+// Moves that the position's symmetries map onto one another rate the same, only one of each is searched
+UTTTAI::RootSearch::RootSearch(const BitState &position) : root(position), moves(Symmetry::DistinctMoves(position)), ratings(moves.size(), 0), order(moves.size())
+{
+    for (size_t i = 0; i < moves.size(); i++) order[i] = i;
+}
+
+// Runs passes of increasing depth over the root moves, up to maxDepth, until the deadline passes, the node limit
+// (0 = none) is used up, the stop flag is raised, the search tree is exhausted or a guaranteed win is found.
+void UTTTAI::Deepen(RootSearch &search, int maxDepth, std::chrono::steady_clock::time_point deadline, long nodeLimit, std::atomic<bool> &stop, bool verbose)
+{
+    const BitState &root = search.root;
+    const std::vector<Move> &moves = search.moves;
+    int searchDepth = std::max(search.depth + 1, INITIAL_SEARCH_DEPTH);
+    auto startTime = std::chrono::steady_clock::now();
+
+    while (searchDepth <= maxDepth && !search.exhausted && search.winningMove < 0 && (!nodeLimit || search.counters.nodes < nodeLimit)) {
+        if (verbose) LOG_DEBUG("Starting pass #" << searchDepth - INITIAL_SEARCH_DEPTH + 1 << " with a search depth of " << searchDepth << ".");
+
+        std::vector<int> passRatings(moves.size());
+        std::vector<char> done(moves.size());
+        std::vector<char> exhausted(moves.size());
+        SearchCounters pass;
+        bool completed = SearchPass(root, moves, search.order, searchDepth, deadline, nodeLimit ? nodeLimit - search.counters.nodes : 0, stop, passRatings, done, exhausted, pass);
+        search.counters.Add(pass);
+
+        // Moves rated in a pass that was cut short still have a deeper rating than before. As the best moves
+        // of the previous pass are searched first, these are the ones that matter most.
+        int rated = 0;
+        for (size_t i = 0; i < moves.size(); i++) {
+            if (!done[i]) continue;
+            search.ratings[i] = passRatings[i];
+            rated++;
+            if (search.ratings[i] >= WIN_SCORE && search.winningMove < 0) {
+                if (verbose) LOG_INFO("Found a route to a guaranteed win... Breaking off search!");
+                search.winningMove = i;
+            }
+        }
+        long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+        search.iterations.push_back(IterationStats{searchDepth, pass.nodes, elapsed, rated, completed});
+        if (!completed) {
+            if (verbose) LOG_INFO("Ran out of budget during pass #" << searchDepth - INITIAL_SEARCH_DEPTH + 1 << " after rating " << rated << " of " << moves.size() << " moves.");
+            break;
+        }
+        search.depth = searchDepth;
+
+        // Next pass starts with the best moves of this one
+        std::stable_sort(search.order.begin(), search.order.end(), [&](int a, int b) { return search.ratings[a] > search.ratings[b]; });
+
+        search.exhausted = true;
+        for (size_t i = 0; i < moves.size(); i++) {
+            if (!exhausted[i]) search.exhausted = false;
+            else if (verbose) LOG_DEBUG("Exhausted search tree of move #" << i << ".");
+        }
+        if (verbose) LOG_DEBUG("Finished pass #" << searchDepth - INITIAL_SEARCH_DEPTH + 1 << ".");
+        if (search.exhausted)
+        {
+            if (verbose) LOG_INFO("Entire search tree was exhausted! Bot knows how this game will end if played perfectly by both sides.");
+        }
+        else if (verbose) LOG_DEBUG("MiniMax did not find definite outcome for a perfectly played match...");
+        searchDepth++; // Increase search depth for next iteration.
+    }
+}
+
+// Thinks on the opponent's time. First guesses the opponent's reply with a shallow search, then searches
+// the position after that reply as if it were our turn, until told to stop. Whatever happens the
+// transposition table is warmed up for the positions the opponent is likely to leave us.
+void UTTTAI::Ponder(BitState position)
+{
+    auto forever = std::chrono::steady_clock::time_point::max();
+    RootSearch guess(position);
+    if (guess.moves.size() < 2) return;
+    Deepen(guess, PONDER_GUESS_DEPTH, forever, 0, ponderStop, false);
+    if (ponderStop || guess.depth == 0) return;
+
+    ponderReply = guess.moves[guess.winningMove >= 0 ? guess.winningMove : guess.order[0]];
+    ponderResult = RootSearch(doMove(position, ponderReply));
+    if (ponderResult.moves.empty()) return;
+    Deepen(ponderResult, MAX_PLY, forever, 0, ponderStop, false);
+}
+
+void UTTTAI::StartPondering(const State &state)
+{
+    StopPondering();
+    if (mcts) return;   // Pondering only exists for the minimax engine
+    ponderStop = false;
+    ponderRoot = toBitState(state);
+    ponderReply = Move{-1, -1};
+    ponderResult = RootSearch();
+    pondered = true;
+    ponderThread = std::thread(&UTTTAI::Ponder, this, ponderRoot);
+}
+
+void UTTTAI::StopPondering()
+{
+    if (!ponderThread.joinable()) return;
+    ponderStop = true;
+    ponderThread.join();
+}
+
+// The symmetry of the pondered position that maps the expected reply onto the given one, 0 when there is none
+int UTTTAI::MirroredReply(int reply) const
+{
+    if (ponderReply.x < 0 || reply == toIndex(ponderReply)) return 0;
+    uint8_t stabiliser = Symmetry::Stabiliser(ponderRoot);
+    for (int s = 1; s < SYMMETRIES; s++)
+        if ((stabiliser & (1 << s)) && Symmetry::Square(s, toIndex(ponderReply)) == reply) return s;
+    return 0;
+}
+
+// Works out which move the opponent played since we started pondering, unless the caller said so, and whether we saw it coming
+void UTTTAI::CheckPonderHit(const BitState &root, const Move &played, RootSearch &search)
+{
+    if (!pondered) return;
+    pondered = false;
+    MoveList<int> replies;
+    getMoveIndices(ponderRoot, replies);
+    for (int reply : replies) {
+        if (played.x >= 0 && reply != toIndex(played)) continue;
+        if (doMove(ponderRoot, toMove(reply)).hash != root.hash) continue;
+        int symmetry = MirroredReply(reply);
+        if (symmetry) {
+            // Mirrored, the search of the expected reply holds for the one that was played
+            ponderResult.root = Symmetry::Transform(ponderResult.root, symmetry);
+            for (Move &move : ponderResult.moves) move = toMove(Symmetry::Square(symmetry, toIndex(move)));
+        }
+        if (ponderResult.root.hash == root.hash && ponderResult.root.cells == root.cells) {
+            LOG_INFO("Opponent played " << toMove(reply) << " as predicted, pondering reached depth " << ponderResult.depth << ".");
+            search = ponderResult;
+        } else {
+            LOG_INFO("Opponent played " << toMove(reply) << ", pondered on " << ponderReply << ".");
+        }
+        break;
+    }
+}
+
+Move UTTTAI::findBestMove(const State &state, const int &timeout, const int &timePerMove, SearchStats *stats)
+{
+    auto turnStartTime = std::chrono::steady_clock::now();
+    SearchStats unused;
+    SearchStats &turn = stats ? *stats : unused;
+    turn = SearchStats();
+    turn.engine = mcts ? "mcts" : "minimax";
+    turn.threads = mcts ? 1 : pool.Size();
+    turn.budgetMilliseconds = TimeBudget(timeout, timePerMove);
+
+    turn.move = ChooseMove(state, timeout, timePerMove, turn);
+    turn.milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - turnStartTime).count();
+    return turn.move;
+}
+
+static std::string FormatLine(const std::vector<Move> &line)
+{
+    std::ostringstream text;
+    for (size_t i = 0; i < line.size(); i++) text << (i ? ", " : "") << line[i];
+    return text.str();
+}
+
+// Runs the proof-number solver on the root. Returns true with the first move of a proven win; when it shows
+// there is none instead, what is left of the budget goes into proving that the opponent wins.
+bool UTTTAI::ProveRoot(const BitState &root, std::chrono::steady_clock::time_point deadline, long nodeLimit, Move &move, SearchStats &stats)
+{
+    ProofResult result = proof->Solve(root, root.side, deadline, nodeLimit);
+    stats.proofNodes = proof->LastNodes();
+    if (result == ProofResult::Proven && !proof->LastLine().empty()) {
+        stats.engine = "proof";
+        stats.proof = "win";
+        stats.proofLine = proof->LastLine();
+        stats.nodes = stats.proofNodes;
+        stats.score = WIN_SCORE;
+        stats.exhausted = true;
+        LOG_INFO("Proof search found a forced win in " << stats.proofNodes << " positions: " << FormatLine(stats.proofLine) << ".");
+        move = stats.proofLine[0];
+        return true;
+    }
+
+    if (result == ProofResult::Disproven && (!nodeLimit || stats.proofNodes < nodeLimit)) {
+        result = proof->Solve(root, 1 - root.side, deadline, nodeLimit ? nodeLimit - stats.proofNodes : 0);
+        stats.proofNodes += proof->LastNodes();
+        if (result == ProofResult::Proven) {
+            stats.proof = "loss";
+            stats.proofLine = proof->LastLine();
+            LOG_INFO("Proof search shows the opponent wins by force: " << FormatLine(stats.proofLine) << ".");
+        }
+    }
+    return false;
+}
 
 // Finds the best next move for the bot, using minimax alphabeta and various other rules to determine what moves are best.
-Move UTTTAI::findBestMove(const State &state, const int &timeout, const int &timePerMove)
+Move UTTTAI::ChooseMove(const State &state, const int &timeout, const int &timePerMove, SearchStats &stats)
 {
     auto turnStartTime = std::chrono::steady_clock::now();
     int timeElapsed;
     Move bestMove = Move{ -1, -1};
-    Player me = getCurrentPlayer(state);
-    std::vector<Move> moves = getMoves(state);
+    StopPondering();
+    Move played = opponentMove;     // Only good for this turn
+    opponentMove = Move{-1, -1};
+    RootSearch search(toBitState(state));
+    Player me = getCurrentPlayer(search.root);
+    const std::vector<Move> &moves = search.moves;
     const int moveSize = moves.size();
+    stats.pieces = search.root.pieces;
 
     // Edge cases...
-    if (moves.empty()) std::cerr << "ERROR: Board appears to be full, yet AI is asked to pick a move!" << std::endl;
+    if (moves.empty()) LOG_ERROR("ERROR: Board appears to be full, yet AI is asked to pick a move!");
     if (moveSize == 1) return moves[0]; // Might occur later in matches
 
-    std::vector<int> moveRatings;
-    int searchDepth = INITIAL_SEARCH_DEPTH;
+    // Neither do positions in the opening book
+    Move bookMove;
+    int bookDepth;
+    if (OpeningBook::Get().Probe(search.root, bookMove, bookDepth)) {
+        stats.engine = "book";
+        stats.depth = bookDepth;
+        LOG_INFO("Opening book knows this position, playing move #" << bookMove << ".");
+        return bookMove;
+    }
 
-    do {
-        if (searchDepth > INITIAL_SEARCH_DEPTH) std::cerr << "Enough time left to do another pass with depth: " << searchDepth << "." << std::endl;
-        std::cerr << "Starting pass #" << searchDepth - INITIAL_SEARCH_DEPTH + 1 << " with a search depth of " << searchDepth << "." << std::endl;
+    // Solved endgames need no search at all
+    int tablebaseMove = TablebaseMove(search, stats.score);
+    if (tablebaseMove >= 0) {
+        stats.engine = "tablebase";
+        stats.exhausted = true;
+        LOG_INFO("Endgame tablebase knows the outcome, playing move #" << moves[tablebaseMove] << ".");
+        return moves[tablebaseMove];
+    }
 
-        bool searchTreeExhausted = true;
+    if (mcts) {
+        bestMove = mcts->FindBestMove(search.root, turnStartTime + std::chrono::milliseconds(TimeBudget(timeout, timePerMove)), options.nodesPerMove);
+        stats.depth = mcts->LastDepth();
+        stats.nodes = mcts->LastPlayouts();
+        stats.treeNodes = mcts->LastTreeNodes();
+        stats.winRate = mcts->LastWinRate();
+        stats.counters.maxPly = mcts->LastDepth();
+        timeElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - turnStartTime).count();
+        LOG_INFO("MCTS picked move #" << bestMove << " in " << timeElapsed << " milliseconds." << "\n");
+        return bestMove;
+    }
 
-        for (int i = 0; i < moves.size(); i++) {
-            bool fullMoveTreeEvaluated = true;
-            State child = doMove(state, moves[i]);
-            moveRatings.push_back(TreeSearch::MiniMaxAB(child, EvaluateState, GetChildStates, searchDepth, false, me, -50, +50, &fullMoveTreeEvaluated));
-            if (moveRatings[i] >= +1) {
-                std::cerr << "Found a route to a guaranteed win... Breaking off search!" << std::endl;
-                return moves[i];
-            }
-            if (!fullMoveTreeEvaluated) searchTreeExhausted = false;
-            else std::cerr << "Exhausted search tree of move #" << i << "." << std::endl;
-        }
-        std::cerr << "Finished pass #" << searchDepth - INITIAL_SEARCH_DEPTH + 1 << "." << std::endl;
-        if (searchTreeExhausted)
-        {
-            std::cerr << "Entire search tree was exhausted! Bot knows how this game will end if played perfectly by both sides." << std::endl;
-            break;
-        }
-        else std::cerr << "MiniMax did not find definite outcome for a perfectly played match..." << std::endl;
-        searchDepth++; // Increase search depth for next iteration.
+    table.NewSearch();
+    for (MoveOrdering<int> &ordering : orderings) ordering.Age();
+    long allocationsBefore = AllocCounter::Count();
+    CheckPonderHit(search.root, played, search);
+    stats.ponderHit = search.depth > 0;
+    search.counters = SearchCounters();     // Only what is searched on our own time counts
+    search.iterations.clear();
+
+    // Forced wins are proven first, on their share of the budget; whatever the solver proves on the way is in
+    // the transposition table for minimax. A search limited by depth alone has no budget to take a share of.
+    if (proof && search.depth < PONDER_INSTANT_DEPTH && (options.nodesPerMove || !options.maxDepth)) {
+        auto proofDeadline = turnStartTime + std::chrono::milliseconds(TimeBudget(timeout, timePerMove) * options.proofShare / 100);
+        Move proofMove;
+        if (ProveRoot(search.root, proofDeadline, options.nodesPerMove * options.proofShare / 100, proofMove, stats)) return proofMove;
+    }
 
-        timeElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - turnStartTime).count();
-    } while ( // Keep searching 1 level deeper if there's enough time left
-            (timeElapsed * 3 < timePerMove && timeout > (5 * timePerMove))
-            || // Game has a branching factor of 7, expect the time elapsed each iteration to be multiplied with this factor in worst case.
-            (timeElapsed * 6 < timePerMove)
-            );
+    // Keep deepening until the time or node budget is used up, the pass that is running then is cut short.
+    // When pondering already searched deep enough there is no need to spend any time at all.
+    if (search.depth < PONDER_INSTANT_DEPTH) {
+        std::atomic<bool> stop(false);
+        Deepen(search, options.maxDepth ? std::min(options.maxDepth, MAX_PLY) : MAX_PLY, turnStartTime + std::chrono::milliseconds(TimeBudget(timeout, timePerMove)), options.nodesPerMove, stop, true);
+    }
+    stats.depth = search.depth;
+    stats.nodes = search.counters.nodes;
+    stats.counters = search.counters;
+    stats.iterations = search.iterations;
+    stats.exhausted = search.exhausted || search.winningMove >= 0;
+    if (AllocCounter::Enabled()) stats.allocations = AllocCounter::Count() - allocationsBefore;
+    stats.score = search.winningMove >= 0 ? WIN_SCORE : *std::max_element(search.ratings.begin(), search.ratings.end());
+    if (search.winningMove >= 0) return moves[search.winningMove];
+    const std::vector<int> &moveRatings = search.ratings;
+
+    LOG_INFO("Search reached depth " << search.depth << " using " << pool.Size() << " thread(s).");
+
+    if (AllocCounter::Enabled())
+        LOG_INFO("Search performed " << AllocCounter::Count() - allocationsBefore << " heap allocations.");
 
     // Find the moves with the highest score
     // There might be multiple moves with the same score
     std::vector<Move> bestMoves;
     int highestRating = moveRatings[0];
-    for (int i = 0; i < moves.size(); i++) {
+    for (size_t i = 0; i < moves.size(); i++) {
         if (moveRatings[i] > highestRating) {
             highestRating = moveRatings[i];
             bestMoves.clear();
@@ -68,78 +362,92 @@ Move UTTTAI::findBestMove(const State &state, const int &timeout, const int &tim
             bestMoves.push_back(moves[i]);
     }
 
-    if (highestRating <= -1)
-        std::cerr << "All examined moves result in a loss! Chances are I will lose." << std::endl;
+    if (highestRating <= -WIN_SCORE)
+        LOG_INFO("All examined moves result in a loss! Chances are I will lose.");
 
     std::vector<Move> secondaryBestMoves;
 
     // Evaluate the highest scoring moves using various evaluation methods
     if(bestMoves.size() > 1) {
-        secondaryBestMoves = EvaluateBestMoves(state, bestMoves, me);
+        secondaryBestMoves = EvaluateBestMoves(search.root, bestMoves, me);
 
         //If multiple moves come out with the same score, select one of them randomly
         if (secondaryBestMoves.size() > 1)
-            bestMove = *select_randomly(secondaryBestMoves.begin(), secondaryBestMoves.end());
+            bestMove = *select_randomly(secondaryBestMoves.begin(), secondaryBestMoves.end(), random);
         else if (secondaryBestMoves.size() == 1)
             bestMove = secondaryBestMoves[0];
         else
-            std::cerr << "ERROR: secondaryBestMoves list is empty!" << std::endl;
+            LOG_ERROR("ERROR: secondaryBestMoves list is empty!");
     }
     else if (bestMoves.size() == 1)
         bestMove = bestMoves[0];
     else
-        std::cerr << "ERROR: Best moves list is empty!" << std::endl;
+        LOG_ERROR("ERROR: Best moves list is empty!");
 
     if (bestMove.x == -1 && bestMove.y == -1) {
-        std::cerr << "ERROR: No best move was found!" << std::endl;
-        bestMove = *select_randomly(bestMoves.begin(), bestMoves.end());
+        LOG_ERROR("ERROR: No best move was found!");
+        bestMove = *select_randomly(bestMoves.begin(), bestMoves.end(), random);
     }
 
     timeElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - turnStartTime).count();
-    std::cerr << "______________________________________________________________________________________________" << std::endl;
-    std::cerr << "Search yields optimal position to do move: #" << bestMove << std::endl;
-    std::cerr << "Search for move finished in " << timeElapsed << " milliseconds." << std::endl;
-    std::cerr << "______________________________________________________________________________________________" << std::endl << std::endl;
+    LOG_INFO("______________________________________________________________________________________________");
+    LOG_INFO("Search yields optimal position to do move: #" << bestMove);
+    LOG_INFO("Search for move finished in " << timeElapsed << " milliseconds.");
+    LOG_INFO("______________________________________________________________________________________________" << "\n");
 
     return bestMove; // Return highest-rating move
 }
 
-// Evaluates all given moves based on various rules and rates them accordingly
-std::vector<Move>  UTTTAI::EvaluateBestMoves(const State &state, const std::vector<Move> &bestMoves, const Player &me){
+// Which players can still win the board: nobody once it is won, otherwise whoever still has a line free of the other's discs
+static Player WinnableBy(const MicroboardsSummary &boards, int board)
+{
+    if ((boards.won[0] | boards.won[1]) & (1 << board)) return Player::None;
+    bool xCanWin = boards.openLines[0][board] > 0, oCanWin = boards.openLines[1][board] > 0;
+    return xCanWin && oCanWin ? Player::Both : xCanWin ? Player::X : oCanWin ? Player::O : Player::None;
+}
+
+// Evaluates all given moves based on various rules and rates them accordingly. Every microboard is analysed at once,
+// before the moves and after each of them, instead of rebuilding the boards a rule looks at for every rule.
+std::vector<Move>  UTTTAI::EvaluateBestMoves(const BitState &position, const std::vector<Move> &bestMoves, const Player &me){
     std::vector<Move> secondaryBestMoves;
     Player other = me == Player::X ? Player::O : Player::X;
-    auto turnStartTime = std::chrono::steady_clock::now();
-    int timeElapsed;
+    const int mine = toSide(me), theirs = toSide(other);
+    auto startTime = std::chrono::steady_clock::now();
     int highestMicroRating = -999;
     int microRating;
 
-    std::vector<MacroState> myPreferredBoards = GetPreferredMacroBoards(state, me, 2);
-    std::vector<MacroState> enemyPreferredBoards = GetPreferredMacroBoards(state, other, 2);
-    std::vector<MacroState> myLessPreferredBoards = GetPreferredMacroBoards(state, me, 1);
-    std::vector<MacroState> enemyLessPreferredBoards = GetPreferredMacroBoards(state, other, 1);
+    const MicroboardsSummary before = analyseMicroboards(position.cells[0], position.cells[1]);
+    std::vector<MacroState> myPreferredBoards = GetPreferredMacroBoards(before, position.active, me, 2);
+    std::vector<MacroState> enemyPreferredBoards = GetPreferredMacroBoards(before, position.active, other, 2);
+    std::vector<MacroState> myLessPreferredBoards = GetPreferredMacroBoards(before, position.active, me, 1);
+    std::vector<MacroState> enemyLessPreferredBoards = GetPreferredMacroBoards(before, position.active, other, 1);
 
     // Evaluate & rates all moves in bestMoves
     for(Move move : bestMoves){
-        State child = doMove(state, move);
-        std::cerr << "move: " << move << std::endl;
+        const int index = toIndex(move), board = index / 9;
+        BitState child = position;
+        Undo undo;
+        makeMove(child, index, undo);
+        const MicroboardsSummary after = analyseMicroboards(child.cells[0], child.cells[1]);
+        LOG_DEBUG("move: " << move);
 
-        microRating = EvaluateMicroState(GetMicroState(child, move, false), me);
-        std::cerr << "score1: " << microRating << std::endl;
+        microRating = EvaluateMicroState(after, board, me);
+        LOG_DEBUG("score1: " << microRating);
 
-        microRating += EvaluateNextPossibilities(GetMicroState(child, move, true), me);
-        std::cerr << "score2: " << microRating << std::endl;
+        microRating += EvaluateNextPossibilities(after, index % 9, me);
+        LOG_DEBUG("score2: " << microRating);
 
         //Check if this move setups up two in a row for my bot
-        if(ttt::CheckSetups(GetMicroState(state, move, false), me) < ttt::CheckSetups(GetMicroState(child, move, false), me))
+        if(before.setups[mine][board] < after.setups[mine][board])
             microRating += 4;
 
         //Check if this move blocks an enemy setup of two in a row
-        if(ttt::CheckSetups(GetMicroState(state, move, false), other) > ttt::CheckSetups(GetMicroState(child, move, false), other))
+        if(before.setups[theirs][board] > after.setups[theirs][board])
             microRating += 5;
 
-        std::cerr << "score3: " << microRating << std::endl;
+        LOG_DEBUG("score3: " << microRating);
 
-        Player winnable = ttt::IsWinnableBy(GetMicroState(state, move, false));
+        Player winnable = WinnableBy(before, board);
 
         // Check if move lines up with atleast 2 macroboards won by me
         for(MacroState macroState : myPreferredBoards){
@@ -150,7 +458,7 @@ std::vector<Move>  UTTTAI::EvaluateBestMoves(const State &state, const std::vect
                 }
                 if (enemyPreferredBoards.size() == 0) {
                     microRating += 3;
-                    if(ttt::CheckSetups(GetMicroState(state, move, false), me) < ttt::CheckSetups(GetMicroState(child, move, false), me))
+                    if(before.setups[mine][board] < after.setups[mine][board])
                         microRating += 3;
                 }
             } else if (move.x % 3 == macroState.x && move.y % 3 == macroState.y) {
@@ -163,7 +471,7 @@ std::vector<Move>  UTTTAI::EvaluateBestMoves(const State &state, const std::vect
                     }
                 }
             }
-            std::cerr << "myscore4: " << microRating << std::endl;
+            LOG_DEBUG("myscore4: " << microRating);
         }
 
         // Check if move lines up with atleast 2 macroboards won by the enemy
@@ -175,7 +483,7 @@ std::vector<Move>  UTTTAI::EvaluateBestMoves(const State &state, const std::vect
                 }
                 if (myPreferredBoards.size() == 0) {
                     microRating += 3;
-                    if(enemyPreferredBoards.size() == 1 && ttt::CheckSetups(GetMicroState(state, move, false), other) > 0 && ttt::CheckSetups(GetMicroState(child, move, false), other) == 0)
+                    if(enemyPreferredBoards.size() == 1 && before.setups[theirs][board] > 0 && after.setups[theirs][board] == 0)
                         microRating += 10;
                 }
             } else if (move.x % 3 == macroState.x && move.y % 3 == macroState.y) {
@@ -186,7 +494,7 @@ std::vector<Move>  UTTTAI::EvaluateBestMoves(const State &state, const std::vect
                     microRating -= 3;
                 }
             }
-            std::cerr << "enemyscore4: " << microRating << std::endl;
+            LOG_DEBUG("enemyscore4: " << microRating);
         }
 
         // Check if move lines up with atleast 1 macroboard won by me
@@ -202,7 +510,7 @@ std::vector<Move>  UTTTAI::EvaluateBestMoves(const State &state, const std::vect
                         microRating -= 3;
                     }
                 }
-                std::cerr << "1myscore14: " << microRating << std::endl;
+                LOG_DEBUG("1myscore14: " << microRating);
             }
         }
 
@@ -219,11 +527,11 @@ std::vector<Move>  UTTTAI::EvaluateBestMoves(const State &state, const std::vect
                         microRating -= 3;
                     }
                 }
-                std::cerr << "enemyscore14: " << microRating << std::endl;
+                LOG_DEBUG("enemyscore14: " << microRating);
             }
         }
 
-        std::cerr << "totalscore: " << microRating << std::endl;
+        LOG_DEBUG("totalscore: " << microRating);
 
         //Check if move is higher than or equal to current highestscore, if
         //higher it will clear the list, if the same it will add this move to the list.
@@ -237,51 +545,97 @@ std::vector<Move>  UTTTAI::EvaluateBestMoves(const State &state, const std::vect
         }
     }
 
-    std::cerr << "______________________________________________________________________________________________" << std::endl;
-    std::cerr << "Secondary evaluation yields: #" << secondaryBestMoves.size() << " different moves" << std::endl;
-    std::cerr << "Secondary evaluation finished in " << timeElapsed << " milliseconds." << std::endl;
-    std::cerr << "______________________________________________________________________________________________" << std::endl << std::endl;
+    LOG_DEBUG("______________________________________________________________________________________________");
+    LOG_DEBUG("Secondary evaluation yields: #" << secondaryBestMoves.size() << " different moves");
+    long timeElapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+    LOG_DEBUG("Secondary evaluation finished in " << timeElapsed << " microseconds.");
+    LOG_DEBUG("______________________________________________________________________________________________" << "\n");
 
     return secondaryBestMoves;
 }
 
-// Evaluate the state to see if there's a winner.
-int UTTTAI::EvaluateState(const State &state, const Player &player)
+// Tablebase values count as won or lost games, just like the end of the game in EvaluateState
+bool UTTTAI::ProbeTablebase(const BitState &state, const Player &player, int &value)
+{
+    EndgameValue known;
+    if (!Tablebase::Get().Probe(state, known)) return false;
+    int score = known.outcome == Outcome::Win ? WIN_SCORE : known.outcome == Outcome::Loss ? -WIN_SCORE : 0;
+    value = toPlayer(state.side) == player ? score : -score;
+    return true;
+}
+
+// Index of the best root move when the tablebase knows every reply, the fastest win or the slowest loss, and its
+// rating. -1 when some reply is not in the table.
+int UTTTAI::TablebaseMove(const RootSearch &search, int &score)
+{
+    if (search.root.open > Tablebase::Get().MaxEmpty() + 1) return -1;
+    int best = -1, bestScore = 0;
+    for (size_t i = 0; i < search.moves.size(); i++) {
+        BitState child = doMove(search.root, search.moves[i]);
+        MoveList<int> replies;
+        getMoveIndices(child, replies);
+        EndgameValue value{Outcome::Loss, 0};       // For the opponent
+        if (getWinner(child) == Player::None) {
+            if (replies.empty()) value = EndgameValue{Outcome::Draw, 0};
+            else if (!Tablebase::Get().Probe(child, value)) return -1;
+        }
+        EndgameValue parent = value.Parent();
+        if (best < 0 || parent.Score() > bestScore) {
+            best = i;
+            bestScore = parent.Score();
+            score = parent.outcome == Outcome::Win ? WIN_SCORE : parent.outcome == Outcome::Loss ? -WIN_SCORE : 0;
+        }
+    }
+    return best;
+}
+
+// Rates the state for the given player: +-WIN_SCORE once the game is won, otherwise a weighted sum of features that
+// makeMove keeps up to date or that take a single table lookup, so every leaf costs the same small constant.
+int UTTTAI::EvaluateState(const BitState &state, const Player &player)
 {
     Player winner = getWinner(state);                           // Is there a winner?
-    if (winner == player) return +50;						    // Bot has won in evaluated state
-    if (winner == Player::None) return 0;						// No winner
-    return -50;                                                 // Opponent has won in evaluated state
+    if (winner == player) return +WIN_SCORE;                    // Bot has won in evaluated state
+    if (winner != Player::None) return -WIN_SCORE;              // Opponent has won in evaluated state
+    if (!state.active) return 0;                                // All microboards decided without a winner
+
+    // Drawn microboards block macro lines for both players
+    const ttt::Info &macroX = ttt::Lookup(state.won[0], state.won[1] | state.drawn);
+    const ttt::Info &macroO = ttt::Lookup(state.won[0] | state.drawn, state.won[1]);
+    int score = BOARD_WON_SCORE * (__builtin_popcount(state.won[0]) - __builtin_popcount(state.won[1]))
+              + MACRO_SETUP_SCORE * (macroX.setups[0] - macroO.setups[1])
+              + MACRO_LINE_SCORE * (macroX.openLines[0] - macroO.openLines[1])
+              + MICRO_SETUP_SCORE * (state.setups[0] - state.setups[1]);
+
+    // Being sent to a decided microboard lets the side to move pick any board
+    if (state.active & (state.active - 1)) score += state.side == 0 ? FREE_CHOICE_SCORE : -FREE_CHOICE_SCORE;
+
+    return player == Player::X ? score : -score;
 }
 
 // Evaluate the microboard (one of the 3x3 boards) and check if there's a winner and whether or not the bot can still win
-int UTTTAI::EvaluateMicroState(const MicroState &state, const Player &player)
+int UTTTAI::EvaluateMicroState(const MicroboardsSummary &boards, int board, const Player &player)
 {
-    Player winner = ttt::GetWinner(state);                                           // Is there a winner?
-    if (winner == player) return +10;						                         // Bot has won in evaluated state
-    Player possibleWinner = ttt::IsWinnableBy(state);
-    if(possibleWinner != player && possibleWinner != Player::Both) return -10;       // This microstate can only be won by the enemy
-    if (winner == Player::None) return 0;						                     // No winner
-    return -10;                                                                      // Opponent has won in evaluated state
+    if (boards.won[toSide(player)] & (1 << board)) return +10;                      // Bot has won in evaluated state
+    Player possibleWinner = WinnableBy(boards, board);
+    if(possibleWinner != player && possibleWinner != Player::Both) return -10;       // Only the enemy can still win it, or already has
+    return 0;                                                                        // No winner
 }
 
 // Evaluate the next posibilities of a state and assigns a score accordingly
-int UTTTAI::EvaluateNextPossibilities(const MicroState &state, const Player &me){
-    MicroState nextBoard = state;
-    Player other = me == Player::X ? Player::O : Player::X;
+int UTTTAI::EvaluateNextPossibilities(const MicroboardsSummary &boards, int board, const Player &me){
+    const int mine = toSide(me), theirs = 1 - mine;
+    const bool closed = (boards.won[0] | boards.won[1] | boards.full) & (1 << board);
     int score = 0;
 
-    auto nextMoves = ttt::GetMoves(nextBoard);
-
-    if(ttt::CheckSetups(nextBoard, me) > 0) score -= 3;            // Making this move would allow the opponent to block my win next microboard
-    if(ttt::CheckSetups(nextBoard, other) > 0) score -= 4;         // Making this move would allow the opponent to win the next microboard
-    if(nextMoves.size() == 0) score -= 11;                   // Making this move gives the opponent the most options, as he gets to choose from all microboards
+    if(boards.setups[mine][board] > 0) score -= 3;           // Making this move would allow the opponent to block my win next microboard
+    if(boards.setups[theirs][board] > 0) score -= 4;         // Making this move would allow the opponent to win the next microboard
+    if(closed) score -= 11;                                  // Making this move gives the opponent the most options, as he gets to choose from all microboards
 
     if(score != 0){
         return score;
     }
 
-    Player nextWinnableBy = ttt::IsWinnableBy(nextBoard);
+    Player nextWinnableBy = WinnableBy(boards, board);
 
     // This board can still be won by both players, it is still of good use to both players
     if(nextWinnableBy == Player::Both) return 0;
@@ -290,96 +644,23 @@ int UTTTAI::EvaluateNextPossibilities(const MicroState &state, const Player &me)
     if(nextWinnableBy == Player::X || nextWinnableBy == Player::O) return 1;
 
     // It would be ideal to force an opponent to move here, as this board is not of any use to anyone
-    if(nextWinnableBy == Player::None) return 8;
-}
-
-// Get all possible childstates of a given state
-std::vector<State> UTTTAI::GetChildStates(const State &state)
-{
-    std::vector<State> children;
-    std::vector<Move> moves = getMoves(state);
-    for (Move m : moves) children.push_back(doMove(state, m));
-    return children;
-}
-
-// Get the microboard (3x3 board) of a given state and a given move, with option to return
-// either the current or next microboard
-MicroState UTTTAI::GetMicroState(const State &state, const Move &move, bool getNext){
-    std::array<Player, 9> microState;
-    int xStart;
-    int yStart;
-
-    if(!getNext) {
-        xStart = (move.y / 3) * 3;
-        yStart = (move.x / 3) * 3;
-    }
-    else {
-        xStart = (move.y % 3) * 3;
-        yStart = (move.x % 3) * 3;
-    }
-
-    int i = 0;
-
-    for (int x = xStart; x < xStart + 3; x++) {
-        for (int y = yStart; y < yStart + 3; y++) {
-            microState[i] = state.board[x][y];
-            i++;
-        }
-    }
-
-    return microState;
+    return 8;
 }
 
-// Check whether there are x number of macroboard wins in a row for given player in the given state
-std::vector<MacroState> UTTTAI::GetPreferredMacroBoards (const State &state, const Player &player, const int num){
+// Check whether there are x number of macroboard wins in a row for given player. Only the boards that are active right
+// now count as free, any other undecided board blocks a line.
+std::vector<MacroState> UTTTAI::GetPreferredMacroBoards(const MicroboardsSummary &boards, uint16_t active, const Player &player, const int num){
+    static constexpr uint16_t lines[8] = {0x007, 0x038, 0x1C0, 0x049, 0x092, 0x124, 0x111, 0x054};
     std::vector<MacroState> preferredBoards;
-    State current;
-    std::array<std::array<MacroState, 3>, 8> wins =
-            {{
-                     {MacroState{0, 0}, MacroState{0, 1}, MacroState{0, 2}},
-                     {MacroState{1, 0}, MacroState{1, 1}, MacroState{1, 2}},
-                     {MacroState{2, 0}, MacroState{2, 1}, MacroState{2, 2}},
-                     {MacroState{0, 0}, MacroState{1, 0}, MacroState{2, 0}},
-                     {MacroState{0, 1}, MacroState{1, 1}, MacroState{2, 1}},
-                     {MacroState{0, 2}, MacroState{1, 2}, MacroState{2, 2}},
-                     {MacroState{0, 0}, MacroState{1, 1}, MacroState{2, 2}},
-                     {MacroState{2, 0}, MacroState{1, 1}, MacroState{0, 2}}
-             }};
-
-    // Clean up & add all necessary info of state to current for usage later
-    for (int r=0; r<3; r++) {
-        for (int c = 0; c < 3; c++) {
-            if(state.macroboard[r][c] == Player::Active)
-                current.macroboard[r][c] = Player::None;
-            if(state.macroboard[r][c] == Player::X)
-                current.macroboard[r][c] = Player::X;
-            if(state.macroboard[r][c] == Player::O)
-                current.macroboard[r][c] = Player::O;
-        }
-    }
+    const uint16_t won = boards.won[toSide(player)];
 
-    for(std::array<MacroState, 3> win : wins) {
-        std::vector<MacroState> temp;
-        int count = 0;
-
-        for (MacroState m : win) {
-            if (current.macroboard[m.y][m.x] == player) count++;
-            else if (current.macroboard[m.y][m.x] == Player::None) {
-                temp.push_back(m);
-            }
-            else if (current.macroboard[m.y][m.x] != Player::None) {
-                count = 0;
-                break;
-            }
-        }
-
-        if(count == num && temp.size() != 0){
-            for(MacroState ms : temp){
-                preferredBoards.push_back(ms);
-            }
-            temp.clear();
+    for(uint16_t line : lines) {
+        if((line & ~(won | active)) || __builtin_popcount(line & won) != num) continue;
+        for(uint16_t free = line & active; free; free &= free - 1) {
+            int board = __builtin_ctz(free);
+            preferredBoards.push_back(MacroState{board % 3, board / 3});
         }
     }
 
     return preferredBoards;
-}
\ No newline at end of file
+}
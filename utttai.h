@@ -4,11 +4,55 @@
 #ifndef UTTTAI_H
 #define UTTTAI_H
 
-#include "utttbot.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+
 #include "uttt.h"
 #include "ttt.h"
+#include "bitboard.h"
+#include "transposition.h"
+#include "threadpool.h"
+#include "TreeSearch.h"
+#include "searchstats.h"
+#include "tablebase.h"
+#include "book.h"
+#include "mcts.h"
+#include "microboards.h"
+#include "proofsearch.h"
 
 #define INITIAL_SEARCH_DEPTH 1
+#define DEFAULT_HASH_MEGABYTES 32
+#define SAFETY_MARGIN 15            // Milliseconds kept free for everything around the search
+#define PONDER_GUESS_DEPTH 6        // Depth used to guess the opponent's reply while pondering
+#define PONDER_INSTANT_DEPTH 12     // After a ponder hit this deep, answer without searching
+
+// Leaf evaluation weights. Any position that is not won scores well below WIN_SCORE.
+#define WIN_SCORE 1000
+#define BOARD_WON_SCORE 20          // Per microboard won
+#define MACRO_SETUP_SCORE 30        // Per two won microboards in a macro line that can still be completed
+#define MACRO_LINE_SCORE 3          // Per macro line that can still be won
+#define MICRO_SETUP_SCORE 4         // Per two in a row in an undecided microboard
+#define FREE_CHOICE_SCORE 12        // For the side to move when it may play in any microboard
+
+enum class Engine { Minimax, MCTS };
+
+struct AIOptions {
+    Engine engine = Engine::Minimax;
+    int hashMegabytes = DEFAULT_HASH_MEGABYTES;
+    int mctsMegabytes = DEFAULT_MCTS_MEGABYTES;
+    int threads = 1;
+    bool ponder = false;
+    bool statsJson = false;     // The bot logs the SearchStats of every turn as one JSON line
+    long nodesPerMove = 0;      // Search budget in nodes (playouts for MCTS) on top of the clock, 0 = none
+    int maxDepth = 0;           // Deepest minimax pass on top of the clock, 0 = none
+    int proofShare = 0;         // Percent of the move budget the proof-number solver gets ahead of minimax, 0 = off
+    int proofMegabytes = DEFAULT_PROOF_MEGABYTES;
+    uint64_t seed = 0;          // Seeds every random choice, 0 = different every run
+};
+
 
 struct MacroState {
     int x = -1;
@@ -16,18 +60,90 @@ struct MacroState {
 };
 
 class UTTTAI {
-    static std::vector<Move> EvaluateBestMoves(const State &state, const std::vector<Move> &bestMoves, const Player &me);
+    // Iterative deepening state for one position
+    struct RootSearch {
+        BitState root;
+        std::vector<Move> moves;
+        std::vector<int> ratings;       // Rating of the deepest search of each move
+        std::vector<int> order;         // Indices into moves, best first
+        int depth = 0;                  // Deepest completed pass
+        SearchCounters counters;        // Summed over all passes
+        std::vector<IterationStats> iterations;
+        int winningMove = -1;
+        bool exhausted = false;
+
+        RootSearch() = default;
+        explicit RootSearch(const BitState &position);
+    };
+
+    AIOptions options;
+    TranspositionTable table;   // Kept between passes and turns, shared by all search threads
+    ThreadPool pool;            // Search threads, kept for the lifetime of the AI
+    std::vector<MoveOrdering<int>> orderings;   // Killers and history of each search thread
+    std::unique_ptr<MCTS> mcts;                 // Only allocated when it is the selected engine
+    std::unique_ptr<ProofSearch> proof;         // Only allocated when it gets a share of the budget
+    std::mt19937 random;                        // Picks between moves that rate the same
+
+    std::thread ponderThread;
+    std::atomic<bool> ponderStop{false};
+    bool pondered = false;      // Whether the fields below belong to the current turn
+    BitState ponderRoot;        // Position the opponent has to move in
+    Move ponderReply{-1, -1};   // The reply we expect
+    RootSearch ponderResult;    // Our search of the position after that reply
+    Move opponentMove{-1, -1};  // The reply that was played, when the caller knows it
 
-    static int EvaluateState(const State &state, const Player &player);
-    static int EvaluateMicroState(const MicroState &state, const Player &player);
-    static int EvaluateNextPossibilities(const MicroState &state, const Player &me);
+    bool SearchPass(const BitState &root, const std::vector<Move> &moves, const std::vector<int> &order, int depth, std::chrono::steady_clock::time_point deadline, long nodeLimit, std::atomic<bool> &stop, std::vector<int> &ratings, std::vector<char> &done, std::vector<char> &exhausted, SearchCounters &counters);
+    void Deepen(RootSearch &search, int maxDepth, std::chrono::steady_clock::time_point deadline, long nodeLimit, std::atomic<bool> &stop, bool verbose);
+    void Ponder(BitState position);
+    int MirroredReply(int reply) const;
+    void CheckPonderHit(const BitState &root, const Move &played, RootSearch &search);
+    bool ProveRoot(const BitState &root, std::chrono::steady_clock::time_point deadline, long nodeLimit, Move &move, SearchStats &stats);
+    Move ChooseMove(const State &state, const int &timeout, const int &timePerMove, SearchStats &stats);
 
-    static std::vector<State> GetChildStates(const State &state);
-    static MicroState GetMicroState(const State &state, const Move &move, const bool getNext);
-    static std::vector<MacroState> GetPreferredMacroBoards (const State &state, const Player &player, const int num);
+    static std::vector<Move> EvaluateBestMoves(const BitState &position, const std::vector<Move> &bestMoves, const Player &me);
+
+    static int EvaluateState(const BitState &state, const Player &player);
+    static int EvaluateMicroState(const MicroboardsSummary &boards, int board, const Player &player);
+    static int EvaluateNextPossibilities(const MicroboardsSummary &boards, int board, const Player &me);
+
+    static bool ProbeTablebase(const BitState &state, const Player &player, int &value);
+
+    static int TablebaseMove(const RootSearch &search, int &score);
+
+    static std::vector<MacroState> GetPreferredMacroBoards(const MicroboardsSummary &boards, uint16_t active, const Player &player, const int num);
 
 public:
-    static Move findBestMove(const State &state, const int &timeout, const int &timePerMove);
+    // The game as TreeSearch sees it, every rating for the side to move. Public so tools can run searches of their own.
+    struct SearchPolicy {
+        using Position = BitState;
+        using Move = int;       // Square index
+        using Undo = ::Undo;
+
+        static void GenerateMoves(const BitState &state, MoveList<int> &moves) { getMoveIndices(state, moves); }
+        static void MakeMove(BitState &state, int move, Undo &undo) { makeMove(state, move, undo); }
+        static void UnmakeMove(BitState &state, int move, const Undo &undo) { unmakeMove(state, move, undo); }
+        static int Evaluate(const BitState &state) { return EvaluateState(state, toPlayer(state.side)); }
+        static uint64_t Hash(const BitState &state) { return state.hash; }
+        static bool Probe(const BitState &state, int &value)
+        {
+            return state.open <= Tablebase::Get().MaxEmpty() && ProbeTablebase(state, toPlayer(state.side), value);
+        }
+    };
+
+    explicit UTTTAI(const AIOptions &options = AIOptions());
+    ~UTTTAI();
+
+    // Milliseconds a search may take with the given timebank and time per move
+    static int TimeBudget(int timeout, int timePerMove);
+
+    // Fills in stats, when given, with what the search did
+    Move findBestMove(const State &state, const int &timeout, const int &timePerMove, SearchStats *stats = nullptr);
+
+    // Search in the background on the opponent's time, state is the position after our move
+    void StartPondering(const State &state);
+    void StopPondering();
+    // The move the opponent played since our last one, which spares working it out from the new position
+    void OpponentPlayed(const Move &move) { opponentMove = move; }
 };
 
 #endif //UTTTAI_H
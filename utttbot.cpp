@@ -2,112 +2,104 @@
 // Jeffrey Drost
 
 #include "utttbot.h"
+#include "log.h"
+#include "protocol.h"
 
 #include <iostream>
-#include <sstream>
 #include <chrono>
 
+UTTTBot::UTTTBot(const AIOptions &options) : ai(options), ponder(options.ponder), statsJson(options.statsJson) {
+}
+
 void UTTTBot::run() {
 	std::string line;
 	while (std::getline(std::cin, line)) input(line);
 }
 
-void UTTTBot::move(int timeout) {
-    if(firstMove){
-        firstMove = false;
+Move UTTTBot::decide(const GameSession &game, UTTTAI &ai, int timeout, SearchStats &stats) {
+    // Without an opening book the first move is the centre, the book knows better
+    if(game.firstMove && !OpeningBook::Get().Size()){
+        stats.engine = "opening";
+        stats.move = Move{4,4};
+        return stats.move;
+    }
+    if (game.opponentMove.x >= 0) ai.OpponentPlayed(game.opponentMove);
+    return ai.findBestMove(game.state, timeout, game.time_per_move, &stats);
+}
 
-        Move r = Move{4,4};
+void UTTTBot::move(int timeout) {
+	SearchStats stats;
+	Move m = decide(game, ai, timeout, stats);
+	std::cout << "place_disc " << m << std::endl;
+	if (statsJson) LOG_INFO(stats.ToJson());
+	game.played(m);
+	if (ponder) ai.StartPondering(game.state);
+}
 
-        std::cout << "place_disc " << r << std::endl;
-    }else {
-        Move m = UTTTAI::findBestMove(state, timeout, time_per_move);
-        std::cout << "place_disc " << m << std::endl;
-    }
+void GameSession::played(const Move &m) {
+	firstMove = false;
+	state = doMove(state, m);
 }
 
-void UTTTBot::update(std::string &key, std::string &value) {
+void GameSession::update(std::string_view key, std::string_view value) {
 	if (key == "round") {
-		round = std::stoi(value);
+		round = toInt(value);
 	} else if (key == "field") {
-		int row = 0;
-		int col = 0;
-		std::vector<std::string> fields = split(value, ',');
-		for (std::string &field : fields) {
-			if (field == "0") {
-				state.board[row][col] = Player::X; 
-			} else if (field == "1") {
-				state.board[row][col] = Player::O;
-			} else {
-				state.board[row][col] = Player::None;
-			}
-			col++;
-			if (col == 9) {
-				row++; 
-				col = 0;
+		// Decoded in place. Normally the only difference with the board after our move is the opponent's disc.
+		int changed = 0;
+		bool placed = false;
+		Move move{-1, -1};
+		for (int row = 0; row < 9; row++) {
+			for (int col = 0; col < 9; col++) {
+				Player cell = toCell(nextToken(value, ','));
+				if (cell == state.board[row][col]) continue;
+				changed++;
+				placed = state.board[row][col] == Player::None;
+				move = Move{col, row};
+				state.board[row][col] = cell;
 			}
 		}
+		opponentMove = changed == 1 && placed ? move : Move{-1, -1};
 	} else if (key == "macroboard") {
-		int row = 0;
-		int col = 0;
-		std::vector<std::string> fields = split(value, ',');
-		for (std::string &field : fields) {
-			if (field == "-1") {
-				state.macroboard[row][col] = Player::Active;
-			} else if (field == "0") {
-				state.macroboard[row][col] = Player::X;
-			} else if (field == "1") {
-				state.macroboard[row][col] = Player::O;
-			} else {
-				state.macroboard[row][col] = Player::None;
-			}
-			col++;
-			if (col == 3) {
-				row++;
-				col = 0;
+		for (int row = 0; row < 3; row++) {
+			for (int col = 0; col < 3; col++) {
+				state.macroboard[row][col] = toMacroCell(nextToken(value, ','));
 			}
 		}
 	}
 }
 
-void UTTTBot::setting(std::string &key, std::string &value) {
+void GameSession::setting(std::string_view key, std::string_view value) {
 	if (key == "timebank") {
-		timebank = std::stoi(value);
+		timebank = toInt(value);
 	} else if (key == "time_per_move") {
-		time_per_move = std::stoi(value);
+		time_per_move = toInt(value);
 	} else if (key == "player_names") {
-		std::vector<std::string> names = split(value, ',');
-		player_names[0] = names[0];
-		player_names[1] = names[1];
+		player_names[0] = std::string(nextToken(value, ','));
+		player_names[1] = std::string(nextToken(value, ','));
 	} else if (key == "your_bot") {
 	    if(value == player_names[0]){
             firstMove = true;
 	    }
-		your_bot = value;
+		your_bot = std::string(value);
 	} else if (key == "your_botid") {
-		your_botid = std::stoi(value);
+		your_botid = toInt(value);
 	}
 }
 
-std::vector<std::string> UTTTBot::split(const std::string &s, char delim) {
-	std::vector<std::string> elems;
-	std::stringstream ss(s);
-	std::string item;
-	while (std::getline(ss, item, delim)) {
-		elems.push_back(item);
-	}
-	return elems;
-}
-
-void UTTTBot::input(std::basic_string<char> & line)
+void UTTTBot::input(std::string_view line)
 {
-    std::vector<std::string> command = split(line, ' ');
-    if (command[0] == "settings") {
-        setting(command[1], command[2]);
-    } else if (command[0] == "update" && command[1] == "game") {
-        update(command[2], command[3]);
-    } else if (command[0] == "action" && command[1] == "move") {
-        move(std::stoi(command[2]));
+    std::string_view rest = line;
+    std::string_view command = nextToken(rest, ' ');
+    std::string_view first = nextToken(rest, ' ');
+    std::string_view second = nextToken(rest, ' ');
+    if (command == "settings") {
+        game.setting(first, second);
+    } else if (command == "update" && first == "game") {
+        game.update(second, nextToken(rest, ' '));
+    } else if (command == "action" && first == "move") {
+        move(toInt(second));
     } else {
-        std::cerr << "Unknown command: " << line << std::endl;
+        LOG_WARN("Unknown command: " << line);
     }
-}
\ No newline at end of file
+}
@@ -5,6 +5,7 @@
 #define UTTTBOT_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <chrono>
 #include <iostream>
@@ -13,26 +14,45 @@
 #include "uttt.h"
 #include "ttt.h"
 
-class UTTTBot {
-	int timebank;
-	int time_per_move;
+#define DEFAULT_TIMEBANK 10000         // Until a game sends its settings
+#define DEFAULT_TIME_PER_MOVE 500
+
+// One game as the protocol describes it, kept up to date by its settings and update lines
+struct GameSession {
+	int timebank = DEFAULT_TIMEBANK;
+	int time_per_move = DEFAULT_TIME_PER_MOVE;
 	std::string player_names[2];
-    int round;
+    int round = 0;
 	std::string your_bot;
-	int your_botid;
+	int your_botid = 0;
 	bool firstMove = false;
-	State state;
+	State state;                    // After our last move until the next field arrives
+	Move opponentMove{-1, -1};      // Found by comparing that with the new field, -1 when unknown
+
+	void setting(std::string_view key, std::string_view value);
+	void update(std::string_view key, std::string_view value);
+	// Our move was sent
+	void played(const Move &m);
+};
+
+class UTTTBot {
+	GameSession game;
+	UTTTAI ai;
+	bool ponder;
+	bool statsJson;
 
-	std::vector<std::string> split(const std::string &s, char delim);
-	void setting(std::string &key, std::string &value);
-	void update(std::string &key, std::string &value);
 	void move(int timeout);
 
 public:
+	explicit UTTTBot(const AIOptions &options = AIOptions());
+
 	void run();
 
-    void input(std::basic_string<char> &basic_string);
+	// Handles one line of the protocol, without copying or allocating anything on the per-turn commands
+	void input(std::string_view line);
+
+	// The move to play in the game, searched by ai unless the opening needs no search
+	static Move decide(const GameSession &game, UTTTAI &ai, int timeout, SearchStats &stats);
 };
 
 #endif // UTTTBOT_H
-
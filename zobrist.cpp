@@ -0,0 +1,32 @@
+// zobrist.cpp
+
+#include "zobrist.h"
+
+// splitmix64, a small generator that is easy to run in a constexpr function
+static constexpr uint64_t NextKey(uint64_t &seed)
+{
+    uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static constexpr Zobrist::Keys BuildKeys()
+{
+    Zobrist::Keys keys{};
+    uint64_t seed = 0x5577A1;
+    for (int p = 0; p < 2; p++)
+        for (int i = 0; i < 81; i++)
+            keys.cells[p][i] = NextKey(seed);
+
+    uint64_t boards[9] = {};
+    for (int b = 0; b < 9; b++) boards[b] = NextKey(seed);
+    for (int mask = 0; mask < 512; mask++)
+        for (int b = 0; b < 9; b++)
+            if (mask & (1 << b)) keys.active[mask] ^= boards[b];
+
+    keys.side = NextKey(seed);
+    return keys;
+}
+
+constexpr Zobrist::Keys Zobrist::keys = BuildKeys();
@@ -0,0 +1,20 @@
+// zobrist.h
+
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+// Random keys for Zobrist hashing of a BitState. Generated at compile time from a fixed seed,
+// so hashes are identical between builds and can be stored in files.
+class Zobrist {
+public:
+    struct Keys {
+        uint64_t cells[2][81];  // Disc of X / O on square index
+        uint64_t active[512];   // Active macroboard mask, already combined per mask
+        uint64_t side;          // O to move
+    };
+    static const Keys keys;
+};
+
+#endif //ZOBRIST_H